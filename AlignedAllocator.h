@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+namespace ndtech {
+
+  // Allocator for containers whose storage must start on an Alignment byte boundary, such
+  // as columns that batch kernels read with aligned vector loads
+  template <typename T, size_t Alignment>
+  struct AlignedAllocator {
+
+    using value_type = T;
+
+    static constexpr size_t StorageAlignment = Alignment > alignof(T) ? Alignment : alignof(T);
+
+    template <typename U>
+    struct rebind {
+      using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {
+    }
+
+    T* allocate(size_t count) {
+      return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(StorageAlignment)));
+    }
+
+    void deallocate(T* pointer, size_t) {
+      ::operator delete(pointer, std::align_val_t(StorageAlignment));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const {
+      return true;
+    }
+
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const {
+      return false;
+    }
+  };
+
+}
\ No newline at end of file
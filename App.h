@@ -2,9 +2,17 @@
 #include "pch.h"
 #include "PlatformApp.h"
 #include "TypeUtilities.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <numeric>
 #include <tuple>
 #include <type_traits>
+#include "ParallelFor.h"
 #include "Scheduler.h"
+#include "SchedulerTrace.h"
+#include "SystemSchedule.h"
+#include "TaskGraph.h"
 
 namespace ndtech {
 
@@ -31,8 +39,11 @@ namespace ndtech {
     using ThisType = App<Settings, Derived>;
     using Components = typename Settings::Components;
     using ComponentSystems = typename Settings::ComponentSystems;
+    using ConcurrentComponentSystems = typename Settings::ConcurrentComponentSystems;
+    using Schedule = SystemSchedule<Components, ComponentSystems, ConcurrentComponentSystems>;
     using EntityIndexType = typename Settings::EntityIndexType;
     using EntityType = typename Settings::EntityType;
+    using EntityHandle = typename Settings::EntityHandle;
     using EntityVector = std::vector<EntityType>;
 
     using ComponentSystemsTuple = TypeUtilities::Convert<ComponentSystems, std::tuple>;
@@ -44,6 +55,8 @@ namespace ndtech {
     EntityVector m_entities;
     EntityIndexType m_freeEntityIndex = 0;
     EntityIndexType m_entitiesCapacity = 0;
+    // Slots below m_freeEntityIndex whose entity was removed, reused before new slots
+    std::vector<uint32_t> m_freeEntities;
 
     std::vector<EntityIndexType> m_freeComponentIndices;
     std::vector<EntityIndexType> m_componentCapacities;
@@ -51,35 +64,111 @@ namespace ndtech {
     ComponentVectors m_componentVectors;
     int m_numberOfComponentVectors = std::tuple_size<ComponentVectors>::value;
 
+    // Each component vector is the dense half of a sparse set: its first
+    // m_freeComponentIndices elements are packed, m_componentEntities says which entity owns
+    // each of them and m_componentSlots maps an entity index back to its element.
+    static constexpr size_t ComponentCount = std::tuple_size<ComponentVectors>::value;
+    static constexpr uint32_t NoComponent = UINT32_MAX;
+    std::array<std::vector<uint32_t>, ComponentCount> m_componentEntities;
+    std::array<std::vector<uint32_t>, ComponentCount> m_componentSlots;
+
     ndtech::Scheduler                               m_scheduler;
+    // When it has nodes, UpdateComponentSystems runs this graph instead of updating the
+    // systems one after another
+    ndtech::TaskGraph                               m_updateGraph;
+
+    // A ParallelSafe component system's components are updated in chunks of about this many
+    // bytes, each a whole number of cache lines, spread over m_scheduler
+    static constexpr size_t ParallelChunkBytes = 16 * 1024;
+    static constexpr size_t CacheLineBytes = 64;
 
     App<TSettings, Derived>() {
     }
 
+    // ParallelSafe systems and the systems of a phase only update in parallel when the
+    // scheduler has workers, which the default SingleThread scheduler does not
+    explicit App<TSettings, Derived>(SchedulerSettings schedulerSettings)
+      : m_scheduler(schedulerSettings) {
+    }
+
     ~App<TSettings, Derived>() {
     }
 
 
     EntityType& AddEntity() {
-      IncreaseEntityStorageIfNeeded();
-      EntityType& entity(m_entities[m_freeEntityIndex++]);
+      EntityIndexType entityIndex;
+      if (!m_freeEntities.empty()) {
+        entityIndex = m_freeEntities.back();
+        m_freeEntities.pop_back();
+      }
+      else {
+        IncreaseEntityStorageIfNeeded();
+        entityIndex = m_freeEntityIndex++;
+      }
+
+      EntityType& entity(m_entities[entityIndex]);
       entity.isAlive = true;
       return entity;
     }
 
+    EntityHandle GetHandle(const EntityType& entity) const {
+      EntityHandle handle;
+      handle.index = static_cast<uint32_t>(entity.index);
+      handle.generation = entity.generation;
+      return handle;
+    }
+
+    bool IsAlive(EntityHandle handle) const {
+      return handle.index < m_freeEntityIndex &&
+        m_entities[handle.index].generation == handle.generation &&
+        m_entities[handle.index].isAlive;
+    }
+
+    // nullptr once the entity has been removed
+    EntityType* GetEntity(EntityHandle handle) {
+      return IsAlive(handle) ? &m_entities[handle.index] : nullptr;
+    }
+
+    // Returns false if the handle is stale
+    bool RemoveEntity(EntityHandle handle) {
+      if (!IsAlive(handle)) {
+        return false;
+      }
+
+      RemoveComponents(Components{}, handle.index);
+
+      EntityType& entity(m_entities[handle.index]);
+      entity.isAlive = false;
+
+      // A slot whose generation wraps is retired rather than letting an old handle match again
+      if (++entity.generation != 0) {
+        m_freeEntities.push_back(handle.index);
+      }
+      return true;
+    }
+
+    // Replaces the entity's T if it already has one.  entity must be alive; code that
+    // holds on to entities should keep handles and use the overload below.
     template <typename T>
     T& AddComponent(EntityType& entity, T inputComponent) noexcept
     {
 
       static_assert(Settings::template isComponent<T>(), "ndtech::App<TSettings>::AddComponent T is not a component");
+      assert(entity.isAlive);
 
       //e.bitset[Settings::template componentBit<T>()] = true;
 
       int componentVectorNumber = TypeUtilities::IndexOf<T, App::Components>();
       std::vector<T>* componentVector = &std::get<std::vector<T>>(m_componentVectors);
 
-      IncreaseComponentStorageIfNeeded<T>();
-      T* component = &(componentVector->operator[](m_freeComponentIndices[componentVectorNumber]++));
+      uint32_t& slot = m_componentSlots[componentVectorNumber][entity.index];
+      if (slot == NoComponent) {
+        IncreaseComponentStorageIfNeeded<T>();
+        slot = static_cast<uint32_t>(m_freeComponentIndices[componentVectorNumber]++);
+        m_componentEntities[componentVectorNumber][slot] = static_cast<uint32_t>(entity.index);
+      }
+      T* component = &(componentVector->operator[](slot));
+      *component = inputComponent;
 
       using ComponentSystemType = typename GetComponentSystemImpl<T, ComponentSystems>::type;
       if constexpr (TestTypeHasInitializeComponent<ComponentSystemType, App<TSettings, Derived>>{}) {
@@ -90,6 +179,63 @@ namespace ndtech {
       return *component;
     }
 
+    // nullptr, and nothing added, if the entity is gone
+    template <typename T>
+    T* AddComponent(EntityHandle handle, T inputComponent) noexcept {
+      if (!IsAlive(handle)) {
+        return nullptr;
+      }
+      return &AddComponent(m_entities[handle.index], std::move(inputComponent));
+    }
+
+    // nullptr if the entity is gone or has no T
+    template <typename T>
+    T* GetComponent(EntityHandle handle) {
+      if (!IsAlive(handle)) {
+        return nullptr;
+      }
+
+      uint32_t slot = m_componentSlots[ComponentNumber<T>()][handle.index];
+      return slot == NoComponent ? nullptr : &std::get<std::vector<T>>(m_componentVectors)[slot];
+    }
+
+    template <typename T>
+    bool HasComponent(EntityHandle handle) const {
+      return IsAlive(handle) && m_componentSlots[ComponentNumber<T>()][handle.index] != NoComponent;
+    }
+
+    // Moves the last T into the removed one's place, so the component vector stays packed
+    template <typename T>
+    bool RemoveComponent(EntityHandle handle) {
+      return IsAlive(handle) && RemoveComponentAt<T>(handle.index);
+    }
+
+    // Calls visitor(entity, a, b, ...) for every entity with all of ComponentTypes, walking
+    // whichever of their component vectors holds fewest.  visitor must not add or remove
+    // components.
+    template <typename... ComponentTypes, typename VisitorType>
+    void View(VisitorType&& visitor) {
+      static_assert(sizeof...(ComponentTypes) > 0, "ndtech::App<TSettings>::View needs a component type");
+      static_assert((Settings::template isComponent<ComponentTypes>() && ...), "ndtech::App<TSettings>::View ComponentTypes must all be components");
+
+      constexpr std::array<size_t, sizeof...(ComponentTypes)> componentNumbers = { { ComponentNumber<ComponentTypes>()... } };
+
+      size_t smallest = componentNumbers[0];
+      for (size_t componentNumber : componentNumbers) {
+        if (m_freeComponentIndices[componentNumber] < m_freeComponentIndices[smallest]) {
+          smallest = componentNumber;
+        }
+      }
+
+      const std::vector<uint32_t>& entities = m_componentEntities[smallest];
+      for (EntityIndexType componentIndex = 0; componentIndex < m_freeComponentIndices[smallest]; componentIndex++) {
+        uint32_t entityIndex = entities[componentIndex];
+        if (((m_componentSlots[ComponentNumber<ComponentTypes>()][entityIndex] != NoComponent) && ...)) {
+          visitor(m_entities[entityIndex], std::get<std::vector<ComponentTypes>>(m_componentVectors)[m_componentSlots[ComponentNumber<ComponentTypes>()][entityIndex]]...);
+        }
+      }
+    }
+
     void LogStaticStats() {
 
       LOG(INFO) << "There are " << m_numberOfComponentVectors << " component vectors";
@@ -103,6 +249,7 @@ namespace ndtech {
       LOG(INFO) << "entities.size() = " << m_entities.size();
       LOG(INFO) << "entitiesCapacity is " << m_entitiesCapacity;
       LOG(INFO) << "freeEntityIndex is " << m_freeEntityIndex;
+      LOG(INFO) << "freeEntities.size() = " << m_freeEntities.size();
 
       int vectorNumber = 0;
       TypeUtilities::ForTuple(
@@ -133,7 +280,9 @@ namespace ndtech {
       LOG(INFO) << "Logging Alive Entities :: BEGIN";
       for (EntityIndexType entityIndex = 0; entityIndex < m_freeEntityIndex; entityIndex++) {
         EntityType entity = m_entities[entityIndex];
-        LOG(INFO) << "entity.index = " << entity.index << ", entity.isAlive = " << entity.isAlive;
+        if (entity.isAlive) {
+          LOG(INFO) << "entity.index = " << entity.index << ", entity.generation = " << entity.generation;
+        }
       }
       LOG(INFO) << "Logging Alive Entities :: END";
     }
@@ -178,9 +327,14 @@ namespace ndtech {
           componentSystem.PreUpdateComponentSystem(componentSystem, componentVector, this);
         }
 
-        for (EntityIndexType componentIndex = 0; componentIndex < this->m_freeComponentIndices[TypeUtilities::IndexOf<typename ComponentSystemType::Component, App::Components>()]; componentIndex++) {
-          auto component = &componentVector->at(componentIndex);
-          componentSystem.UpdateComponent(component, this);
+        if constexpr (IsParallelSafe<ComponentSystemType>()) {
+          UpdateComponentsInChunks(componentSystem, componentVector->data(), this->m_freeComponentIndices[TypeUtilities::IndexOf<typename ComponentSystemType::Component, App::Components>()]);
+        }
+        else {
+          for (EntityIndexType componentIndex = 0; componentIndex < this->m_freeComponentIndices[TypeUtilities::IndexOf<typename ComponentSystemType::Component, App::Components>()]; componentIndex++) {
+            auto component = &componentVector->at(componentIndex);
+            componentSystem.UpdateComponent(component, this);
+          }
         }
 
         if constexpr (TestTypeHasPostUpdateThisComponentSystem<Derived, decltype(componentSystem)>{}) {
@@ -190,10 +344,71 @@ namespace ndtech {
       }
     }
 
+    // A component system declares static constexpr bool ParallelSafe = true when
+    // UpdateComponent only touches the component it is given
+    template<typename ComponentSystemType>
+    static constexpr bool IsParallelSafe() {
+      if constexpr (TestTypeHasParallelSafe<ComponentSystemType>{}) {
+        return ComponentSystemType::ParallelSafe;
+      }
+      else {
+        return false;
+      }
+    }
+
+    template<typename ComponentSystemType, typename ComponentType>
+    void UpdateComponentsInChunks(ComponentSystemType& componentSystem, ComponentType* components, size_t componentCount) {
+
+      // Stepping this many components moves a whole number of cache lines
+      constexpr size_t lineComponents = CacheLineBytes / std::gcd(CacheLineBytes, sizeof(ComponentType));
+      constexpr size_t chunkComponents = std::max<size_t>(ParallelChunkBytes / (lineComponents * sizeof(ComponentType)), 1) * lineComponents;
+
+      // Every chunk after the first starts on a cache line, if any component does
+      size_t alignedStart = 0;
+      while (alignedStart < lineComponents && reinterpret_cast<uintptr_t>(components + alignedStart) % CacheLineBytes != 0) {
+        alignedStart++;
+      }
+      if (alignedStart == lineComponents) {
+        alignedStart = 0;
+      }
+
+      size_t chunkCount = componentCount > alignedStart ? (componentCount - alignedStart + chunkComponents - 1) / chunkComponents : 1;
+
+      ParallelFor(m_scheduler, chunkCount, [&](size_t chunk) {
+        size_t begin = chunk == 0 ? 0 : alignedStart + chunk * chunkComponents;
+        size_t end = std::min(alignedStart + (chunk + 1) * chunkComponents, componentCount);
+        for (size_t componentIndex = begin; componentIndex < end; componentIndex++) {
+          componentSystem.UpdateComponent(components + componentIndex, this);
+        }
+      });
+    }
+
+    // Adds a node to m_updateGraph that updates one component system.  Order systems with
+    // m_updateGraph.AddEdge; systems with no path between them may run at the same time.
+    template<typename ComponentSystemType>
+    TaskGraph::NodeId AddComponentSystemNode() {
+      return m_updateGraph.AddNode([this]() { UpdateComponentSystem<ComponentSystemType>(); });
+    }
+
     template<typename... ComponentSystemTypes>
     void UpdateComponentSystems(ndtech::TypeUtilities::Typelist<ComponentSystemTypes...>) {
 
-      (UpdateComponentSystem<ComponentSystemTypes>(), ...);
+      if (m_updateGraph.NodeCount() > 0) {
+        m_updateGraph.Run(m_scheduler);
+        return;
+      }
+
+      // Phases run one after another, the systems in a phase at the same time
+      using UpdateFunction = void (ThisType::*)();
+      static constexpr std::array<UpdateFunction, sizeof...(ComponentSystemTypes)> updates = { { &ThisType::template UpdateComponentSystem<ComponentSystemTypes>... } };
+
+      for (size_t phase = 0; phase < Schedule::PhaseCount; phase++) {
+        NDTECH_TRACE_SCOPE("App::UpdatePhase");
+        size_t phaseStart = Schedule::PhaseStarts[phase];
+        ParallelFor(m_scheduler, Schedule::PhaseStarts[phase + 1] - phaseStart, [this, phaseStart](size_t index) {
+          (this->*updates[Schedule::Order[phaseStart + index]])();
+        });
+      }
 
       //TypeUtilities::ForTuple(
       //  [this](auto componentSystem) {
@@ -277,6 +492,8 @@ namespace ndtech {
 
         this->m_timer.Tick([&]()
           {
+            NDTECH_TRACE_SCOPE("App::Frame");
+
             //
             // TODO: Update scene objects.
             //
@@ -285,14 +502,35 @@ namespace ndtech {
             // run as many times as needed to get to the current step.
             //
 
-            UpdateComponentSystems(ComponentSystems{});
+            {
+              NDTECH_TRACE_SCOPE("App::UpdateComponentSystems");
+              UpdateComponentSystems(ComponentSystems{});
+            }
+
+            {
+              NDTECH_TRACE_SCOPE("App::Update");
+              this->Update(this->m_timer);
+            }
 
-            this->Update(this->m_timer);
+            {
+              NDTECH_TRACE_SCOPE("Scheduler::RunFrameTasks");
+              m_scheduler.RunFrameTasks();
+            }
 
-            this->m_renderingSystem.Render(this);
+            {
+              NDTECH_TRACE_SCOPE("App::Render");
+              this->m_renderingSystem.Render(this);
+            }
             //RenderComponentSystems();
 
           });
+
+        // Idle work only gets whatever is left of the frame
+        int64_t slackTicks = this->m_timer.GetFrameSlackTicks();
+        if (slackTicks > 0) {
+          NDTECH_TRACE_SCOPE("Scheduler::RunIdleTasks");
+          m_scheduler.RunIdleTasks(microseconds(slackTicks * 1000000 / StepTimer::TicksPerSecond));
+        }
       }
 
       m_scheduler.Join();
@@ -301,12 +539,49 @@ namespace ndtech {
 
   protected:
 
+    template <typename T>
+    static constexpr size_t ComponentNumber() {
+      return TypeUtilities::Impl::IndexOfImpl<0, T, Components>::value;
+    }
+
+    template <typename T>
+    bool RemoveComponentAt(uint32_t entityIndex) {
+      constexpr size_t componentNumber = ComponentNumber<T>();
+      std::vector<uint32_t>& slots = m_componentSlots[componentNumber];
+      std::vector<uint32_t>& entities = m_componentEntities[componentNumber];
+
+      uint32_t slot = slots[entityIndex];
+      if (slot == NoComponent) {
+        return false;
+      }
+
+      std::vector<T>& componentVector = std::get<std::vector<T>>(m_componentVectors);
+      uint32_t last = static_cast<uint32_t>(--m_freeComponentIndices[componentNumber]);
+      if (slot != last) {
+        componentVector[slot] = std::move(componentVector[last]);
+        entities[slot] = entities[last];
+        slots[entities[slot]] = slot;
+      }
+      slots[entityIndex] = NoComponent;
+      return true;
+    }
+
+    template <typename... ComponentTypes>
+    void RemoveComponents(TypeUtilities::Typelist<ComponentTypes...>, uint32_t entityIndex) {
+      (RemoveComponentAt<ComponentTypes>(entityIndex), ...);
+    }
+
 
     void IncreaseEntityStorageTo(EntityIndexType newCapacity)
     {
       assert(newCapacity > m_entitiesCapacity);
+      // Handles only have 32 bits for the index
+      assert(newCapacity <= EntityHandle::InvalidIndex);
 
       m_entities.resize(newCapacity);
+      for (std::vector<uint32_t>& slots : m_componentSlots) {
+        slots.resize(newCapacity, NoComponent);
+      }
 
       for (auto i(m_entitiesCapacity); i < newCapacity; ++i)
       {
@@ -334,6 +609,7 @@ namespace ndtech {
         [this, &vectorNumber, &componentVectorNumber, newCapacity](auto componentVector) mutable {
           if (vectorNumber == componentVectorNumber) {
             std::get<decltype(componentVector)>(m_componentVectors).resize(newCapacity);
+            m_componentEntities[componentVectorNumber].resize(newCapacity);
             m_componentCapacities[componentVectorNumber] = newCapacity;
           }
 
@@ -349,6 +625,7 @@ namespace ndtech {
       assert(newCapacity > m_componentCapacities[componentVectorNumber]);
 
       std::get<std::vector<ComponentType>>(m_componentVectors).resize(newCapacity);
+      m_componentEntities[componentVectorNumber].resize(newCapacity);
       m_componentCapacities[componentVectorNumber] = newCapacity;
     }
 
@@ -1,13 +1,19 @@
 #pragma once
 
+#include <cstdint>
+
 #include "TypeUtilities.h"
 
 namespace ndtech {
 
-  template<typename ComponentsTypelist, typename ComponentSystemsTypelist>
+  // Component systems that declare Reads and Writes typelists are scheduled from them, see
+  // SystemSchedule.  ConcurrentComponentSystemsTypelist lists systems that do not declare
+  // them but never touch what another one in the list writes, so they may update together.
+  template<typename ComponentsTypelist, typename ComponentSystemsTypelist, typename ConcurrentComponentSystemsTypelist = TypeUtilities::Typelist<>>
   struct ApplicationSettings {
     using Components = ComponentsTypelist;
     using ComponentSystems = ComponentSystemsTypelist;
+    using ConcurrentComponentSystems = ConcurrentComponentSystemsTypelist;
 
 #if NDTECH_HOLO
     using ShaderTypes = TypeUtilities::Typelist< winrt::com_ptr<ID3D11VertexShader>, winrt::com_ptr<ID3D11PixelShader>, winrt::com_ptr<ID3D11GeometryShader>>;
@@ -16,11 +22,25 @@ namespace ndtech {
 #endif
 
     using EntityIndexType = size_t;
+    // Bumped each time an entity's slot is freed, so handles to the old entity go stale
     using EntityType = struct {
       EntityIndexType index;
+      uint32_t generation = 0;
       bool isAlive = false;
     };
 
+    // Refers to one entity for as long as it lives.  Its slot may be reused afterwards, but
+    // with a different generation.
+    struct EntityHandle {
+      static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+      uint32_t index = InvalidIndex;
+      uint32_t generation = 0;
+
+      bool operator==(const EntityHandle& other) const { return index == other.index && generation == other.generation; }
+      bool operator!=(const EntityHandle& other) const { return !(*this == other); }
+    };
+
     template <typename T>
     static constexpr bool isComponent() noexcept
     {
@@ -11,6 +11,7 @@ namespace ndtech {
   }
 
   bool BaseApp::Initialize() {
+    m_fileDataStore.SetByteBudget(FileDataBudgetBytes, [](const std::vector<::byte>& fileData) { return fileData.size(); });
     m_fileDataStore.RunOn(m_fileDataStoreFiber);
     return true;
   }
@@ -29,14 +30,15 @@ namespace ndtech {
 
   std::vector<::byte> BaseApp::GetFileData(std::wstring shaderFileName) {
 
-    if (!m_fileDataStore.ItemExists(shaderFileName)) {
+    return *GetSharedFileData(std::move(shaderFileName));
 
-      std::vector<::byte> shaderFileData = ndtech::utilities::ReadSmallBinaryFileSync(shaderFileName);
-      m_fileDataStore.AddItem(shaderFileName, shaderFileData);
+  }
 
-    }
+  std::shared_ptr<const std::vector<::byte>> BaseApp::GetSharedFileData(std::wstring shaderFileName) {
 
-    return m_fileDataStore.GetItem(shaderFileName);
+    return m_fileDataStore.GetOrCreate(shaderFileName, [&shaderFileName]() {
+      return ndtech::utilities::ReadSmallBinaryFileSync(shaderFileName);
+    });
 
   }
 
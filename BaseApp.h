@@ -13,7 +13,11 @@ namespace ndtech {
     struct ApplicationContext m_applicationContext { 2, "ndtech.BaseApp" };
     StepTimer m_timer;
 
-    NamedItemStore<std::vector<::byte>, std::wstring> m_fileDataStore;
+    // Files read through GetSharedFileData are dropped, least recently used first, once
+    // they pass this many bytes
+    static constexpr size_t FileDataBudgetBytes = 64 * 1024 * 1024;
+
+    NamedItemStore<std::vector<::byte>, std::wstring, SnapshotItemMap> m_fileDataStore;
     boost::fibers::fiber m_fileDataStoreFiber;
 
     BaseApp() = default;
@@ -36,6 +40,7 @@ namespace ndtech {
     virtual void AfterWindowSet();
 
     std::vector<::byte> GetFileData(std::wstring shaderFileName);
+    std::shared_ptr<const std::vector<::byte>> GetSharedFileData(std::wstring shaderFileName);
 
   };    
   
@@ -62,6 +67,12 @@ namespace ndtech {
   template <typename TestType>
   using TestTypeHasUpdateComponent = ndtech::TypeUtilities::is_detected<TestTypeHasUpdateComponentImpl, TestType>;
 
+  template <typename TestType>
+  using TestTypeHasParallelSafeImpl = decltype(TestType::ParallelSafe);
+
+  template <typename TestType>
+  using TestTypeHasParallelSafe = ndtech::TypeUtilities::is_detected<TestTypeHasParallelSafeImpl, TestType>;
+
   template <typename TestType, typename AppType>
   using TestTypeHasInitializeComponentImpl =
     decltype(std::declval<TestType>().InitializeComponent(
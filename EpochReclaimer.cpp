@@ -0,0 +1,134 @@
+#include "pch.h"
+#include "EpochReclaimer.h"
+
+#include <mutex>
+#include <vector>
+
+namespace ndtech {
+
+  // Records are never freed: a thread that exits hands its record to the next new thread
+  struct alignas(64) EpochThreadRecord {
+    // The epoch seen on entering the outermost read section, 0 outside of one
+    std::atomic<uint64_t>     m_epoch{ 0 };
+    std::atomic<bool>         m_inUse{ true };
+    uint32_t                  m_depth = 0;
+    EpochThreadRecord*        m_next = nullptr;
+  };
+
+  namespace {
+
+    struct RetiredObject {
+      void*       m_object;
+      void(*m_deleter)(void*);
+      uint64_t    m_epoch;
+    };
+
+    std::atomic<uint64_t> s_epoch{ 1 };
+    std::atomic<EpochThreadRecord*> s_records{ nullptr };
+
+    std::mutex& GetRetiredMutex() {
+      static std::mutex mutex;
+      return mutex;
+    }
+
+    std::vector<RetiredObject>& GetRetiredObjects() {
+      static std::vector<RetiredObject> retired;
+      return retired;
+    }
+
+    EpochThreadRecord* AcquireRecord() {
+      for (EpochThreadRecord* record = s_records.load(std::memory_order_acquire); record != nullptr; record = record->m_next) {
+        bool inUse = false;
+        if (!record->m_inUse.load(std::memory_order_relaxed)
+          && record->m_inUse.compare_exchange_strong(inUse, true, std::memory_order_acquire)) {
+          return record;
+        }
+      }
+
+      EpochThreadRecord* record = new EpochThreadRecord;
+      EpochThreadRecord* head = s_records.load(std::memory_order_relaxed);
+      do {
+        record->m_next = head;
+      } while (!s_records.compare_exchange_weak(head, record, std::memory_order_release, std::memory_order_relaxed));
+
+      return record;
+    }
+
+    struct ThreadRecordOwner {
+      EpochThreadRecord* m_record = AcquireRecord();
+
+      ~ThreadRecordOwner() {
+        m_record->m_inUse.store(false, std::memory_order_release);
+      }
+    };
+
+    EpochThreadRecord* GetThreadRecord() {
+      thread_local ThreadRecordOwner t_owner;
+      return t_owner.m_record;
+    }
+
+  }
+
+  EpochReclaimer::ReadGuard::ReadGuard()
+    : m_record(GetThreadRecord()) {
+    if (m_record->m_depth++ == 0) {
+      m_record->m_epoch.store(s_epoch.load(std::memory_order_acquire), std::memory_order_relaxed);
+      // Pairs with the fence in Collect: either Collect sees this epoch or this reader
+      // sees every unlink that came before it
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+  }
+
+  EpochReclaimer::ReadGuard::~ReadGuard() {
+    if (--m_record->m_depth == 0) {
+      m_record->m_epoch.store(0, std::memory_order_release);
+    }
+  }
+
+  void EpochReclaimer::Retire(void* object, void(*deleter)(void*)) {
+    // Readers entering from here on see a later epoch, and cannot reach object
+    uint64_t epoch = s_epoch.fetch_add(1, std::memory_order_acq_rel);
+
+    {
+      std::lock_guard<std::mutex> guard(GetRetiredMutex());
+      GetRetiredObjects().push_back(RetiredObject{ object, deleter, epoch });
+    }
+
+    Collect();
+  }
+
+  void EpochReclaimer::Collect() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    uint64_t oldestReader = UINT64_MAX;
+    for (EpochThreadRecord* record = s_records.load(std::memory_order_acquire); record != nullptr; record = record->m_next) {
+      uint64_t epoch = record->m_epoch.load(std::memory_order_acquire);
+      if (epoch != 0 && epoch < oldestReader) {
+        oldestReader = epoch;
+      }
+    }
+
+    std::vector<RetiredObject> expired;
+    {
+      std::lock_guard<std::mutex> guard(GetRetiredMutex());
+      std::vector<RetiredObject>& retired = GetRetiredObjects();
+
+      size_t kept = 0;
+      for (RetiredObject& object : retired) {
+        if (object.m_epoch < oldestReader) {
+          expired.push_back(object);
+        }
+        else {
+          retired[kept++] = object;
+        }
+      }
+      retired.resize(kept);
+    }
+
+    // Deleters run unlocked, they may retire more objects
+    for (RetiredObject& object : expired) {
+      object.m_deleter(object.m_object);
+    }
+  }
+
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace ndtech {
+
+  struct EpochThreadRecord;
+
+  // Deferred deletion for structures whose readers take no locks.  A reader brackets its
+  // accesses with a ReadGuard, which only writes to a cache line owned by its thread.  A
+  // writer that unlinks an object retires it rather than deleting it, and the object is
+  // deleted once no reader that could have seen it is still inside its guard.
+  struct EpochReclaimer {
+
+    // Read sections may nest, but must not block or yield the fiber while they are open
+    struct ReadGuard {
+      ReadGuard();
+      ~ReadGuard();
+
+      ReadGuard(const ReadGuard&) = delete;
+      ReadGuard& operator=(const ReadGuard&) = delete;
+
+    private:
+      EpochThreadRecord*  m_record;
+    };
+
+    // object must already be unreachable for readers that start after this call
+    template <typename ObjectType>
+    static void Retire(ObjectType* object) {
+      Retire(object, [](void* retired) { delete static_cast<ObjectType*>(retired); });
+    }
+
+    static void Retire(void* object, void(*deleter)(void*));
+
+    // Deletes every retired object that no reader can still see.  Retire calls this, so
+    // it only needs calling directly to free the stragglers after readers have finished.
+    static void Collect();
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include "pch.h"
+#include "FiberPool.h"
+#include "SchedulerTrace.h"
+
+#include <boost/fiber/algo/work_stealing.hpp>
+
+#include <cassert>
+
+namespace ndtech {
+
+  namespace {
+    thread_local FiberPool*   t_fiberPool = nullptr;
+  }
+
+  FiberPool::FiberPool(size_t threadCount, LaneCounters* counters)
+    : m_counters(counters),
+    m_threadCount(threadCount > 0 ? threadCount : 1) {
+
+    static std::atomic<bool> s_created{ false };
+    bool alreadyCreated = s_created.exchange(true);
+    assert(!alreadyCreated && "ndtech::FiberPool can only be created once per process");
+    (void)alreadyCreated;
+
+    m_threads.reserve(m_threadCount);
+    for (size_t threadIndex = 0; threadIndex < m_threadCount; threadIndex++) {
+      m_threads.emplace_back(&FiberPool::Run, this);
+    }
+  }
+
+  FiberPool::~FiberPool() {
+    Join();
+  }
+
+  void FiberPool::Submit(Task task) {
+    FiberTask fiberTask{ std::move(task), std::chrono::steady_clock::now() };
+    m_pendingTasks.fetch_add(1, std::memory_order_relaxed);
+
+    boost::fibers::channel_op_status status = m_channel.try_push(std::move(fiberTask));
+    if (status == boost::fibers::channel_op_status::full) {
+      status = m_channel.push(std::move(fiberTask));
+    }
+
+    // Submitted after Join, the task is dropped
+    if (status != boost::fibers::channel_op_status::success) {
+      FinishTask();
+    }
+  }
+
+  bool FiberPool::OnPoolThread() const {
+    return t_fiberPool == this;
+  }
+
+  void FiberPool::Join() {
+    m_channel.close();
+
+    for (std::thread& thread : m_threads) {
+      if (thread.joinable()) {
+        thread.join();
+      }
+    }
+  }
+
+  // Every pool thread joins the same work_stealing group, whose constructor waits until
+  // all of them have.  The thread's main fiber then turns channel entries into fibers;
+  // those can be stolen by any thread in the group, the main fibers cannot.
+  void FiberPool::Run() {
+    t_fiberPool = this;
+
+    boost::fibers::use_scheduling_algorithm<boost::fibers::algo::work_stealing>(static_cast<std::uint32_t>(m_threadCount), true);
+
+    FiberTask fiberTask;
+    while (m_channel.pop(fiberTask) == boost::fibers::channel_op_status::success) {
+      boost::fibers::fiber(boost::fibers::launch::post, [this, fiberTask = std::move(fiberTask)]() mutable {
+        RunTask(fiberTask);
+      }).detach();
+    }
+
+    // The channel is closed and empty, wait for every fiber in the group before the
+    // threads go
+    std::unique_lock<boost::fibers::mutex> lock(m_fibersMutex);
+    m_fibersConditionVariable.wait(lock, [this]() { return m_pendingTasks.load(std::memory_order_acquire) == 0; });
+  }
+
+  void FiberPool::RunTask(FiberTask& fiberTask) {
+    {
+      NDTECH_TRACE_TASK("Fiber task", fiberTask.m_enqueueTime);
+      if (m_counters != nullptr) {
+        m_counters->RecordTask(std::chrono::steady_clock::now() - fiberTask.m_enqueueTime);
+      }
+      fiberTask.m_task();
+    }
+    fiberTask.m_task.Reset();
+
+    FinishTask();
+  }
+
+  void FiberPool::FinishTask() {
+    if (m_pendingTasks.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      std::lock_guard<boost::fibers::mutex> lock(m_fibersMutex);
+      m_fibersConditionVariable.notify_all();
+    }
+  }
+
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <boost/fiber/all.hpp>
+
+#include "SchedulerCounters.h"
+#include "Task.h"
+
+namespace ndtech {
+
+  // Runs each task as a boost::fiber on a set of threads that share the fibers through
+  // boost::fibers::algo::work_stealing.  A task that blocks on a fiber primitive, such as
+  // NamedItemStore::GetItem, suspends only its own fiber and the thread moves on to other
+  // tasks.  Blocking on an OS primitive still pins its thread.
+  // boost keeps the work_stealing thread group in statics that are set up once, so only
+  // one FiberPool can ever be created per process.
+  struct FiberPool {
+
+    // counters, when given, record each task's queueing latency
+    FiberPool(size_t threadCount, LaneCounters* counters = nullptr);
+
+    ~FiberPool();
+
+    FiberPool(const FiberPool&) = delete;
+    FiberPool& operator=(const FiberPool&) = delete;
+
+    // Callable from any thread, fiber or not.  Blocks only when the submission channel is
+    // full.
+    void Submit(Task task);
+
+    // Stops taking tasks, lets every started fiber finish and joins the threads
+    void Join();
+
+    size_t ThreadCount() const { return m_threads.size(); }
+
+    // True on this pool's threads, in any of their fibers.  Blocking there on an OS
+    // primitive holds up every fiber the thread could run instead.
+    bool OnPoolThread() const;
+
+  private:
+    static constexpr size_t ChannelCapacity = 4096;
+
+    struct FiberTask {
+      Task                                    m_task;
+      std::chrono::steady_clock::time_point   m_enqueueTime;
+    };
+
+    void Run();
+
+    void RunTask(FiberTask& fiberTask);
+
+    void FinishTask();
+
+    LaneCounters*                                       m_counters;
+    size_t                                              m_threadCount;
+    boost::fibers::buffered_channel<FiberTask>          m_channel{ ChannelCapacity };
+    std::vector<std::thread>                            m_threads;
+    // Tasks submitted and not yet finished, whether still in the channel or running
+    std::atomic<size_t>                                 m_pendingTasks{ 0 };
+    boost::fibers::mutex                                m_fibersMutex;
+    boost::fibers::condition_variable                   m_fibersConditionVariable;
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "BaseApp.h"
+
+namespace ndtech {
+
+  // No window, no device and nothing to render to.  Used by the tests and benchmarks, which
+  // only drive the component, entity and scheduler parts of App.
+  template <typename TSettings>
+  struct PlatformApp : public BaseApp {
+
+    using Settings = TSettings;
+
+    struct HeadlessRenderingSystem {
+      void* m_app = nullptr;
+      void* m_componentSystems = nullptr;
+      void* m_freeComponentIndices = nullptr;
+      void* m_componentVectors = nullptr;
+
+      void Initialize() {}
+
+      template <typename AppType>
+      void Render(AppType* app) {}
+    };
+
+    HeadlessRenderingSystem m_renderingSystem;
+
+    virtual ~PlatformApp() {
+    }
+
+    void Configure() {
+      Initialize();
+    };
+
+    virtual void Update(StepTimer timer) override {
+      ConcreteUpdate(timer);
+    };
+
+  };
+
+}
\ No newline at end of file
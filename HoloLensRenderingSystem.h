@@ -135,13 +135,13 @@ namespace ndtech
     winrt::event_token                                          m_cameraAddedToken;
     winrt::event_token                                          m_cameraRemovedToken;
 
-    NamedItemStore< winrt::com_ptr<ID3D11VertexShader>, std::wstring > m_vertexShadersStore;
+    NamedItemStore< winrt::com_ptr<ID3D11VertexShader>, std::wstring, ShardedItemMap > m_vertexShadersStore;
     boost::fibers::fiber m_vertexShadersStoreFiber;
 
-    NamedItemStore< winrt::com_ptr<ID3D11PixelShader>, std::wstring > m_pixelShadersStore;
+    NamedItemStore< winrt::com_ptr<ID3D11PixelShader>, std::wstring, ShardedItemMap > m_pixelShadersStore;
     boost::fibers::fiber m_pixelShadersStoreFiber;
 
-    NamedItemStore< winrt::com_ptr<ID3D11GeometryShader>, std::wstring > m_geometryShadersStore;
+    NamedItemStore< winrt::com_ptr<ID3D11GeometryShader>, std::wstring, ShardedItemMap > m_geometryShadersStore;
     boost::fibers::fiber m_geometryShadersStoreFiber;
 
 
@@ -592,18 +592,15 @@ namespace ndtech
       if (!m_vertexShadersStore.ItemExists(shaderFileName)) {
 
 
-        if (!m_app->m_fileDataStore.ItemExists(shaderFileName)) {
-          std::vector<::byte> shaderFileData = ndtech::utilities::ReadDataFiber(shaderFileName);
-          m_app->m_fileDataStore.AddItem(shaderFileName, shaderFileData);
-        };
-
-        std::vector<::byte> shaderFileData = m_app->m_fileDataStore.GetItem(shaderFileName);
+        std::shared_ptr<const std::vector<::byte>> shaderFileData = m_app->m_fileDataStore.GetOrCreate(shaderFileName, [&shaderFileName]() {
+          return ndtech::utilities::ReadDataFiber(shaderFileName);
+        });
         winrt::com_ptr<ID3D11VertexShader> shader = nullptr;
 
         // After the  shader file is loaded, create the shader
         winrt::check_hresult(m_deviceResources->GetD3DDevice()->CreateVertexShader(
-          shaderFileData.data(),
-          shaderFileData.size(),
+          shaderFileData->data(),
+          shaderFileData->size(),
           nullptr,
           shader.put()
         ));
@@ -627,18 +624,15 @@ namespace ndtech
 
       if (!m_pixelShadersStore.ItemExists(shaderFileName)) {
 
-        if (!m_app->m_fileDataStore.ItemExists(shaderFileName)) {
-          std::vector<::byte> shaderFileData = ndtech::utilities::ReadDataFiber(shaderFileName);
-          m_app->m_fileDataStore.AddItem(shaderFileName, shaderFileData);
-        };
-
-        std::vector<::byte> shaderFileData = m_app->m_fileDataStore.GetItem(shaderFileName);
+        std::shared_ptr<const std::vector<::byte>> shaderFileData = m_app->m_fileDataStore.GetOrCreate(shaderFileName, [&shaderFileName]() {
+          return ndtech::utilities::ReadDataFiber(shaderFileName);
+        });
         winrt::com_ptr<ID3D11PixelShader> shader = nullptr;
 
         // After the  shader file is loaded, create the shader
         winrt::check_hresult(m_deviceResources->GetD3DDevice()->CreatePixelShader(
-          shaderFileData.data(),
-          shaderFileData.size(),
+          shaderFileData->data(),
+          shaderFileData->size(),
           nullptr,
           shader.put()
         ));
@@ -662,18 +656,15 @@ namespace ndtech
 
       if (!m_geometryShadersStore.ItemExists(shaderFileName)) {
 
-        if (!m_app->m_fileDataStore.ItemExists(shaderFileName)) {
-          std::vector<::byte> shaderFileData = ndtech::utilities::ReadDataFiber(shaderFileName);
-          m_app->m_fileDataStore.AddItem(shaderFileName, shaderFileData);
-        };
-
-        std::vector<::byte> shaderFileData = m_app->m_fileDataStore.GetItem(shaderFileName);
+        std::shared_ptr<const std::vector<::byte>> shaderFileData = m_app->m_fileDataStore.GetOrCreate(shaderFileName, [&shaderFileName]() {
+          return ndtech::utilities::ReadDataFiber(shaderFileName);
+        });
         winrt::com_ptr<ID3D11GeometryShader> shader = nullptr;
 
         // After the  shader file is loaded, create the shader
         winrt::check_hresult(m_deviceResources->GetD3DDevice()->CreateGeometryShader(
-          shaderFileData.data(),
-          shaderFileData.size(),
+          shaderFileData->data(),
+          shaderFileData->size(),
           nullptr,
           shader.put()
         ));
@@ -706,13 +697,15 @@ namespace ndtech
         { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0,  0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
       } };
 
-      std::vector<::byte> vertexShaderFileData = m_app->m_fileDataStore.GetItem(shaderFileName);
+      std::shared_ptr<const std::vector<::byte>> vertexShaderFileData = m_app->m_fileDataStore.GetOrCreate(shaderFileName, [&shaderFileName]() {
+        return ndtech::utilities::ReadDataFiber(shaderFileName);
+      });
 
       winrt::check_hresult(m_deviceResources->GetD3DDevice()->CreateInputLayout(
         vertexDesc.data(),
         static_cast<UINT>(vertexDesc.size()),
-        vertexShaderFileData.data(),
-        static_cast<UINT>(vertexShaderFileData.size()),
+        vertexShaderFileData->data(),
+        static_cast<UINT>(vertexShaderFileData->size()),
         m_inputLayout.put()
       ));
 
@@ -728,13 +721,15 @@ namespace ndtech
         { "COLOR",    0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
       } };
 
-      std::vector<::byte> vertexShaderFileData = m_app->m_fileDataStore.GetItem(shaderFileName);
+      std::shared_ptr<const std::vector<::byte>> vertexShaderFileData = m_app->m_fileDataStore.GetOrCreate(shaderFileName, [&shaderFileName]() {
+        return ndtech::utilities::ReadDataFiber(shaderFileName);
+      });
 
       winrt::check_hresult(m_deviceResources->GetD3DDevice()->CreateInputLayout(
         vertexDesc.data(),
         static_cast<UINT>(vertexDesc.size()),
-        vertexShaderFileData.data(),
-        static_cast<UINT>(vertexShaderFileData.size()),
+        vertexShaderFileData->data(),
+        static_cast<UINT>(vertexShaderFileData->size()),
         inputLayout.put()
       ));
 
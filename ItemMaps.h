@@ -0,0 +1,469 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <unordered_map>
+
+#include "EpochReclaimer.h"
+
+namespace ndtech {
+
+  // Backends for NamedItemStore.  Every backend has one writer at a time, the store's
+  // apply loop, which calls Publish at the end of each pass.  A backend with LockFreeReads
+  // can be read while it is being written; otherwise the store serializes reads with the
+  // writer.  A backend with ConsistentReads only ever shows readers a published pass.
+  // Read runs a function against a view with Visit and Contains that stays on one state.
+  // VisitWritten is the writer's own lookup and sees changes that are not yet published.
+
+  template <typename NameType, typename ItemType>
+  struct OrderedItemMap {
+
+    static constexpr bool LockFreeReads = false;
+    static constexpr bool ConsistentReads = false;
+
+    template <typename VisitorType>
+    bool Visit(const NameType& name, VisitorType&& visitor) const {
+      auto foundItem = m_items.find(name);
+      if (foundItem == m_items.end()) {
+        return false;
+      }
+      visitor(foundItem->second);
+      return true;
+    }
+
+    bool Contains(const NameType& name) const {
+      return m_items.find(name) != m_items.end();
+    }
+
+    void Assign(NameType&& name, ItemType&& item) {
+      m_items.insert_or_assign(std::move(name), std::move(item));
+    }
+
+    void Erase(const NameType& name) {
+      m_items.erase(name);
+    }
+
+    void Publish(uint64_t) {
+    }
+
+    template <typename VisitorType>
+    bool VisitWritten(const NameType& name, VisitorType&& visitor) const {
+      return Visit(name, visitor);
+    }
+
+    template <typename ReadType>
+    void Read(ReadType&& read) const {
+      read(*this);
+    }
+
+    template <typename VisitorType>
+    void ForEach(VisitorType&& visitor) const {
+      for (auto& item : m_items) {
+        visitor(item.first, item.second);
+      }
+    }
+
+  private:
+    std::map<NameType, ItemType> m_items;
+  };
+
+  // Open-addressing hash map split into shards, with readers that take no locks.  Each
+  // entry is an immutable node holding the key's hash, computed once when it is written,
+  // so probing compares hashes and touches a key only on a hash match, and growing never
+  // rehashes a key.  The writer publishes a new node or a new table with one atomic store
+  // and retires what it replaced through EpochReclaimer, so a reader only ever writes to
+  // its own thread's cache line and lookups scale with the number of reading threads.
+  template <typename NameType, typename ItemType>
+  struct ShardedItemMap {
+
+    static constexpr bool LockFreeReads = true;
+    static constexpr bool ConsistentReads = false;
+    static constexpr size_t ShardBits = 4;
+    static constexpr size_t ShardCount = size_t(1) << ShardBits;
+    static constexpr size_t MinCapacityBits = 4;
+
+    ShardedItemMap() {
+      for (Shard& shard : m_shards) {
+        shard.m_table.store(new Table(MinCapacityBits), std::memory_order_relaxed);
+      }
+    }
+
+    ShardedItemMap(const ShardedItemMap&) = delete;
+    ShardedItemMap& operator=(const ShardedItemMap&) = delete;
+
+    ~ShardedItemMap() {
+      for (Shard& shard : m_shards) {
+        Table* table = shard.m_table.load(std::memory_order_relaxed);
+        for (size_t index = 0; index < table->Capacity(); index++) {
+          Node* node = table->m_slots[index].load(std::memory_order_relaxed);
+          if (node != nullptr && node != Tombstone()) {
+            delete node;
+          }
+        }
+        delete table;
+      }
+    }
+
+    // visitor runs inside a read section and must not block
+    template <typename VisitorType>
+    bool Visit(const NameType& name, VisitorType&& visitor) const {
+      size_t hash = std::hash<NameType>{}(name);
+      EpochReclaimer::ReadGuard guard;
+
+      const Node* node = Find(hash, name);
+      if (node == nullptr) {
+        return false;
+      }
+      visitor(node->m_item);
+      return true;
+    }
+
+    bool Contains(const NameType& name) const {
+      size_t hash = std::hash<NameType>{}(name);
+      EpochReclaimer::ReadGuard guard;
+      return Find(hash, name) != nullptr;
+    }
+
+    void Assign(NameType&& name, ItemType&& item) {
+      size_t hash = std::hash<NameType>{}(name);
+      Shard& shard = ShardFor(hash);
+      Table* table = shard.m_table.load(std::memory_order_relaxed);
+
+      std::atomic<Node*>* freeSlot = nullptr;
+      bool freeSlotIsEmpty = false;
+
+      for (size_t index = table->Start(hash), probes = 0; probes < table->Capacity(); index = (index + 1) & table->Mask(), probes++) {
+        Node* node = table->m_slots[index].load(std::memory_order_relaxed);
+
+        if (node == nullptr) {
+          if (freeSlot == nullptr) {
+            freeSlot = &table->m_slots[index];
+            freeSlotIsEmpty = true;
+          }
+          break;
+        }
+
+        if (node == Tombstone()) {
+          if (freeSlot == nullptr) {
+            freeSlot = &table->m_slots[index];
+          }
+          continue;
+        }
+
+        if (node->m_hash == hash && node->m_name == name) {
+          table->m_slots[index].store(new Node{ hash, std::move(name), std::move(item) }, std::memory_order_release);
+          EpochReclaimer::Retire(node);
+          return;
+        }
+      }
+
+      freeSlot->store(new Node{ hash, std::move(name), std::move(item) }, std::memory_order_release);
+      shard.m_size++;
+      if (freeSlotIsEmpty) {
+        table->m_usedSlots++;
+      }
+
+      // Tombstones count against the load factor, so a rebuild also clears them out
+      if (table->m_usedSlots * 2 > table->Capacity()) {
+        Rebuild(shard);
+      }
+    }
+
+    void Erase(const NameType& name) {
+      size_t hash = std::hash<NameType>{}(name);
+      Shard& shard = ShardFor(hash);
+      Table* table = shard.m_table.load(std::memory_order_relaxed);
+
+      for (size_t index = table->Start(hash), probes = 0; probes < table->Capacity(); index = (index + 1) & table->Mask(), probes++) {
+        Node* node = table->m_slots[index].load(std::memory_order_relaxed);
+
+        if (node == nullptr) {
+          return;
+        }
+
+        if (node != Tombstone() && node->m_hash == hash && node->m_name == name) {
+          table->m_slots[index].store(Tombstone(), std::memory_order_release);
+          shard.m_size--;
+          EpochReclaimer::Retire(node);
+          return;
+        }
+      }
+    }
+
+    void Publish(uint64_t) {
+    }
+
+    template <typename VisitorType>
+    bool VisitWritten(const NameType& name, VisitorType&& visitor) const {
+      return Visit(name, visitor);
+    }
+
+    template <typename ReadType>
+    void Read(ReadType&& read) const {
+      read(*this);
+    }
+
+    // Writer only
+    template <typename VisitorType>
+    void ForEach(VisitorType&& visitor) const {
+      for (const Shard& shard : m_shards) {
+        const Table* table = shard.m_table.load(std::memory_order_relaxed);
+        for (size_t index = 0; index < table->Capacity(); index++) {
+          const Node* node = table->m_slots[index].load(std::memory_order_relaxed);
+          if (node != nullptr && node != Tombstone()) {
+            visitor(node->m_name, node->m_item);
+          }
+        }
+      }
+    }
+
+  private:
+    struct Node {
+      size_t      m_hash;
+      NameType    m_name;
+      ItemType    m_item;
+    };
+
+    struct Table {
+      explicit Table(size_t capacityBits)
+        : m_capacityBits(capacityBits),
+        m_slots(std::make_unique<std::atomic<Node*>[]>(size_t(1) << capacityBits)) {
+      }
+
+      size_t Capacity() const {
+        return size_t(1) << m_capacityBits;
+      }
+
+      size_t Mask() const {
+        return Capacity() - 1;
+      }
+
+      // Fibonacci hashing spreads keys whose std::hash is the identity.  The top bits
+      // pick the shard, so the slot comes from the bits below them.
+      size_t Start(size_t hash) const {
+        return static_cast<size_t>((Mix(hash) << ShardBits) >> (64 - m_capacityBits));
+      }
+
+      size_t                                  m_capacityBits;
+      // Slots holding a node or a tombstone; only the writer reads it
+      size_t                                  m_usedSlots = 0;
+      std::unique_ptr<std::atomic<Node*>[]>   m_slots;
+    };
+
+    struct alignas(64) Shard {
+      std::atomic<Table*>   m_table{ nullptr };
+      // Live nodes; only the writer reads it
+      size_t                m_size = 0;
+    };
+
+    static uint64_t Mix(size_t hash) {
+      return static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ull;
+    }
+
+    // Marks an erased entry so probes carry on past it; never dereferenced
+    static Node* Tombstone() {
+      return reinterpret_cast<Node*>(alignof(Node));
+    }
+
+    Shard& ShardFor(size_t hash) {
+      return m_shards[Mix(hash) >> (64 - ShardBits)];
+    }
+
+    const Shard& ShardFor(size_t hash) const {
+      return m_shards[Mix(hash) >> (64 - ShardBits)];
+    }
+
+    const Node* Find(size_t hash, const NameType& name) const {
+      const Table* table = ShardFor(hash).m_table.load(std::memory_order_acquire);
+
+      for (size_t index = table->Start(hash), probes = 0; probes < table->Capacity(); index = (index + 1) & table->Mask(), probes++) {
+        const Node* node = table->m_slots[index].load(std::memory_order_acquire);
+
+        if (node == nullptr) {
+          return nullptr;
+        }
+
+        if (node != Tombstone() && node->m_hash == hash && node->m_name == name) {
+          return node;
+        }
+      }
+
+      return nullptr;
+    }
+
+    // Copies the live nodes into a table sized for them and publishes it.  Readers still
+    // probing the old table find the same nodes there until it is reclaimed.
+    void Rebuild(Shard& shard) {
+      Table* oldTable = shard.m_table.load(std::memory_order_relaxed);
+
+      size_t capacityBits = MinCapacityBits;
+      while ((size_t(1) << capacityBits) < shard.m_size * 4) {
+        capacityBits++;
+      }
+
+      Table* newTable = new Table(capacityBits);
+      for (size_t oldIndex = 0; oldIndex < oldTable->Capacity(); oldIndex++) {
+        Node* node = oldTable->m_slots[oldIndex].load(std::memory_order_relaxed);
+        if (node == nullptr || node == Tombstone()) {
+          continue;
+        }
+
+        size_t index = newTable->Start(node->m_hash);
+        while (newTable->m_slots[index].load(std::memory_order_relaxed) != nullptr) {
+          index = (index + 1) & newTable->Mask();
+        }
+        newTable->m_slots[index].store(node, std::memory_order_relaxed);
+        newTable->m_usedSlots++;
+      }
+
+      shard.m_table.store(newTable, std::memory_order_release);
+      EpochReclaimer::Retire(oldTable);
+    }
+
+    Shard   m_shards[ShardCount];
+  };
+
+  // Copy-on-write snapshots: readers load the current version with one atomic load and
+  // see exactly what one apply pass published, however many lookups they make against it.
+  // The writer copies a shard the first time it changes it in a pass and Publish swaps in
+  // a new snapshot sharing every unchanged shard; old snapshots go through EpochReclaimer.
+  template <typename NameType, typename ItemType>
+  struct SnapshotItemMap {
+
+    static constexpr bool LockFreeReads = true;
+    static constexpr bool ConsistentReads = true;
+    static constexpr size_t ShardCount = 16;
+
+    using Shard = std::unordered_map<NameType, ItemType>;
+
+    struct Snapshot {
+      uint64_t                        m_version = 0;
+      std::shared_ptr<const Shard>    m_shards[ShardCount];
+
+      template <typename VisitorType>
+      bool Visit(const NameType& name, VisitorType&& visitor) const {
+        const Shard& shard = *m_shards[ShardIndex(name)];
+        auto foundItem = shard.find(name);
+        if (foundItem == shard.end()) {
+          return false;
+        }
+        visitor(foundItem->second);
+        return true;
+      }
+
+      bool Contains(const NameType& name) const {
+        const Shard& shard = *m_shards[ShardIndex(name)];
+        return shard.find(name) != shard.end();
+      }
+    };
+
+    SnapshotItemMap() {
+      Snapshot* snapshot = new Snapshot;
+      for (size_t shardIndex = 0; shardIndex < ShardCount; shardIndex++) {
+        m_shards[shardIndex] = std::make_shared<Shard>();
+        snapshot->m_shards[shardIndex] = m_shards[shardIndex];
+      }
+      m_snapshot.store(snapshot, std::memory_order_release);
+    }
+
+    SnapshotItemMap(const SnapshotItemMap&) = delete;
+    SnapshotItemMap& operator=(const SnapshotItemMap&) = delete;
+
+    ~SnapshotItemMap() {
+      delete m_snapshot.load(std::memory_order_relaxed);
+    }
+
+    template <typename VisitorType>
+    bool Visit(const NameType& name, VisitorType&& visitor) const {
+      EpochReclaimer::ReadGuard guard;
+      return m_snapshot.load(std::memory_order_acquire)->Visit(name, visitor);
+    }
+
+    bool Contains(const NameType& name) const {
+      EpochReclaimer::ReadGuard guard;
+      return m_snapshot.load(std::memory_order_acquire)->Contains(name);
+    }
+
+    // read gets the Snapshot itself, and runs inside a read section so must not block
+    template <typename ReadType>
+    void Read(ReadType&& read) const {
+      EpochReclaimer::ReadGuard guard;
+      read(*m_snapshot.load(std::memory_order_acquire));
+    }
+
+    // Version passed to the last Publish
+    uint64_t Version() const {
+      EpochReclaimer::ReadGuard guard;
+      return m_snapshot.load(std::memory_order_acquire)->m_version;
+    }
+
+    void Assign(NameType&& name, ItemType&& item) {
+      WritableShard(name).insert_or_assign(std::move(name), std::move(item));
+    }
+
+    void Erase(const NameType& name) {
+      size_t shardIndex = ShardIndex(name);
+      if (m_shards[shardIndex]->find(name) != m_shards[shardIndex]->end()) {
+        WritableShard(name).erase(name);
+      }
+    }
+
+    void Publish(uint64_t version) {
+      Snapshot* oldSnapshot = m_snapshot.load(std::memory_order_relaxed);
+      Snapshot* snapshot = new Snapshot;
+      snapshot->m_version = version;
+
+      for (size_t shardIndex = 0; shardIndex < ShardCount; shardIndex++) {
+        snapshot->m_shards[shardIndex] = m_shards[shardIndex];
+        m_copied[shardIndex] = false;
+      }
+
+      m_snapshot.store(snapshot, std::memory_order_release);
+      EpochReclaimer::Retire(oldSnapshot);
+    }
+
+    template <typename VisitorType>
+    bool VisitWritten(const NameType& name, VisitorType&& visitor) const {
+      const Shard& shard = *m_shards[ShardIndex(name)];
+      auto foundItem = shard.find(name);
+      if (foundItem == shard.end()) {
+        return false;
+      }
+      visitor(foundItem->second);
+      return true;
+    }
+
+    // Writer only, sees changes not yet published
+    template <typename VisitorType>
+    void ForEach(VisitorType&& visitor) const {
+      for (const std::shared_ptr<Shard>& shard : m_shards) {
+        for (auto& item : *shard) {
+          visitor(item.first, item.second);
+        }
+      }
+    }
+
+  private:
+    static size_t ShardIndex(const NameType& name) {
+      return static_cast<size_t>((static_cast<uint64_t>(std::hash<NameType>{}(name)) * 0x9E3779B97F4A7C15ull) >> 60);
+    }
+
+    // The published snapshot shares every shard the writer has not copied this pass
+    Shard& WritableShard(const NameType& name) {
+      size_t shardIndex = ShardIndex(name);
+      if (!m_copied[shardIndex]) {
+        m_shards[shardIndex] = std::make_shared<Shard>(*m_shards[shardIndex]);
+        m_copied[shardIndex] = true;
+      }
+      return *m_shards[shardIndex];
+    }
+
+    std::atomic<Snapshot*>        m_snapshot{ nullptr };
+    std::shared_ptr<Shard>        m_shards[ShardCount];
+    bool                          m_copied[ShardCount] = {};
+  };
+
+}
\ No newline at end of file
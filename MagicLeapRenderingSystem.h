@@ -45,16 +45,19 @@ namespace ndtech
 
     using VertexType = ndtech::vertexTypes::VertexPositionColor;
 
-    NamedItemStore<std::string, std::wstring> m_shaderFileDataStore;
+    // Shader sources are only needed until their shader is compiled
+    static constexpr size_t ShaderFileDataBudgetBytes = 1024 * 1024;
+
+    NamedItemStore<std::string, std::wstring, ShardedItemMap> m_shaderFileDataStore;
     boost::fibers::fiber m_shaderFileDataStoreFiber;
 
     NamedItemStore< int, std::pair<std::wstring, std::wstring> > m_shaderProgramStore;
     boost::fibers::fiber m_shaderProgramStoreFiber;
 
-    NamedItemStore< GLuint, std::wstring > m_vertexShaderStore;
+    NamedItemStore< GLuint, std::wstring, ShardedItemMap > m_vertexShaderStore;
     boost::fibers::fiber m_vertexShaderStoreFiber;
 
-    NamedItemStore< GLuint, std::wstring > m_fragmentShaderStore;
+    NamedItemStore< GLuint, std::wstring, ShardedItemMap > m_fragmentShaderStore;
     boost::fibers::fiber m_fragmentShaderStoreFiber;
 
     template <typename AppType, typename ComponentSystemType>
@@ -135,6 +138,7 @@ namespace ndtech
 
     void Initialize() {
 
+      m_shaderFileDataStore.SetByteBudget(ShaderFileDataBudgetBytes, [](const std::string& shaderCode) { return shaderCode.size(); });
       m_shaderFileDataStore.RunOn(m_shaderFileDataStoreFiber);
       m_shaderProgramStore.RunOn(m_shaderProgramStoreFiber);
       m_fragmentShaderStore.RunOn(m_fragmentShaderStoreFiber);
@@ -235,44 +239,32 @@ namespace ndtech
       }
     }
 
+    // Each store makes its item at most once, even when several fibers ask for the same
+    // program at the same time, and a factory that throws leaves nothing to wait for
     unsigned int GetShaderProgramId(std::wstring vertexShaderFilePath, std::wstring fragmentShaderFilePath) {
-      
-      if (!m_shaderProgramStore.ItemExists(std::make_pair(vertexShaderFilePath, fragmentShaderFilePath))) {
-
-        GLuint vertexShaderId = 0;
-        std::string vertexShaderCode;
-        if (!m_vertexShaderStore.ItemExists(vertexShaderFilePath)) {
 
-          if (!m_shaderFileDataStore.ItemExists(vertexShaderFilePath)) {
-            std::string vertexShaderCode = ndtech::utilities::ReadSmallTextFileSync(vertexShaderFilePath);
-            m_shaderFileDataStore.AddItem(vertexShaderFilePath, vertexShaderCode);
-          }
+      return *m_shaderProgramStore.GetOrCreate(std::make_pair(vertexShaderFilePath, fragmentShaderFilePath), [&]() {
 
-          vertexShaderCode = m_shaderFileDataStore.GetItem(vertexShaderFilePath);
-          GLuint vertexShaderId = glCreateShader(GL_VERTEX_SHADER);
+        GLuint vertexShaderId = *m_vertexShaderStore.GetOrCreate(vertexShaderFilePath, [&]() {
+          std::shared_ptr<const std::string> vertexShaderCode = m_shaderFileDataStore.GetOrCreate(vertexShaderFilePath, [&]() {
+            return ndtech::utilities::ReadSmallTextFileSync(vertexShaderFilePath);
+          });
 
-          m_vertexShaderStore.AddItem(vertexShaderFilePath, vertexShaderId);
-        }
-        vertexShaderId = m_vertexShaderStore.GetItem(vertexShaderFilePath);
-        CompileAndCheckShader(vertexShaderId, vertexShaderCode);
+          GLuint shaderId = glCreateShader(GL_VERTEX_SHADER);
+          CompileAndCheckShader(shaderId, *vertexShaderCode);
+          return shaderId;
+        });
 
 
-        GLuint fragmentShaderId = 0;
-        std::string fragmentShaderCode;
-        if (!m_fragmentShaderStore.ItemExists(fragmentShaderFilePath)) {
+        GLuint fragmentShaderId = *m_fragmentShaderStore.GetOrCreate(fragmentShaderFilePath, [&]() {
+          std::shared_ptr<const std::string> fragmentShaderCode = m_shaderFileDataStore.GetOrCreate(fragmentShaderFilePath, [&]() {
+            return ndtech::utilities::ReadSmallTextFileSync(fragmentShaderFilePath);
+          });
 
-          if (!m_shaderFileDataStore.ItemExists(fragmentShaderFilePath)) {
-            std::string fragmentShaderCode = ndtech::utilities::ReadSmallTextFileSync(fragmentShaderFilePath);
-            m_shaderFileDataStore.AddItem(fragmentShaderFilePath, fragmentShaderCode);
-          }
-
-          fragmentShaderCode = m_shaderFileDataStore.GetItem(fragmentShaderFilePath);
-          GLuint fragmentShaderId = glCreateShader(GL_FRAGMENT_SHADER);
-
-          m_fragmentShaderStore.AddItem(fragmentShaderFilePath, fragmentShaderId);
-        }
-        fragmentShaderId = m_fragmentShaderStore.GetItem(fragmentShaderFilePath);
-        CompileAndCheckShader(fragmentShaderId, fragmentShaderCode);
+          GLuint shaderId = glCreateShader(GL_FRAGMENT_SHADER);
+          CompileAndCheckShader(shaderId, *fragmentShaderCode);
+          return shaderId;
+        });
 
 
         unsigned int shaderProgramId = glCreateProgram();
@@ -284,11 +276,8 @@ namespace ndtech
         glDeleteShader(vertexShaderId);
         glDeleteShader(fragmentShaderId);
 
-        m_shaderProgramStore.AddItem(std::make_pair(vertexShaderFilePath, fragmentShaderFilePath), shaderProgramId);
-      }
-      
-      // TODO:  The line below will hang if there is an error that does not throw.  I need to add a timeout to GetItem that throws to avoid long delays
-      return m_shaderProgramStore.GetItem(std::make_pair(vertexShaderFilePath, fragmentShaderFilePath));
+        return shaderProgramId;
+      });
 
     }
 
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+
+namespace ndtech {
+
+  struct MpscNode {
+    std::atomic<MpscNode*> m_next{ nullptr };
+  };
+
+  // Intrusive multi-producer single-consumer queue (Vyukov).  Push is a single atomic
+  // exchange so producers never block or retry.  Pop belongs to one consumer thread and
+  // returns nullptr when the queue is empty or when a producer is between its exchange and
+  // linking its node; that node is picked up by the next Pop.
+  // NodeType must derive from MpscNode.
+  template <typename NodeType>
+  struct MpscQueue {
+
+    MpscQueue()
+      : m_head(&m_stub),
+      m_tail(&m_stub) {
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    void Push(NodeType* node) {
+      PushNode(node);
+    }
+
+    NodeType* Pop() {
+      MpscNode* tail = m_tail;
+      MpscNode* next = tail->m_next.load(std::memory_order_acquire);
+
+      if (tail == &m_stub) {
+        if (next == nullptr) {
+          return nullptr;
+        }
+        m_tail = next;
+        tail = next;
+        next = next->m_next.load(std::memory_order_acquire);
+      }
+
+      if (next != nullptr) {
+        m_tail = next;
+        return static_cast<NodeType*>(tail);
+      }
+
+      if (tail != m_head.load(std::memory_order_acquire)) {
+        // a producer has swapped the head but not linked it yet
+        return nullptr;
+      }
+
+      // tail is the last node, put the stub back behind it so it can be handed out
+      PushNode(&m_stub);
+
+      next = tail->m_next.load(std::memory_order_acquire);
+      if (next != nullptr) {
+        m_tail = next;
+        return static_cast<NodeType*>(tail);
+      }
+
+      return nullptr;
+    }
+
+    // Consumer only.  False while a producer is still linking a node that Pop could not
+    // hand out yet, so the consumer can tell that apart from a queue that is really empty.
+    bool Empty() const {
+      return m_head.load(std::memory_order_acquire) == m_tail;
+    }
+
+  private:
+    void PushNode(MpscNode* node) {
+      node->m_next.store(nullptr, std::memory_order_relaxed);
+      MpscNode* previous = m_head.exchange(node, std::memory_order_acq_rel);
+      previous->m_next.store(node, std::memory_order_release);
+    }
+
+    alignas(64) std::atomic<MpscNode*>  m_head;
+    alignas(64) MpscNode*               m_tail;
+    MpscNode                            m_stub;
+  };
+
+}
\ No newline at end of file
@@ -2,27 +2,128 @@
 
 #include "pch.h"
 
-#include <map>
+#include <unordered_map>
 #include <vector>
 #include <tuple>
 #include <boost/fiber/all.hpp>
-#include <ndtech/TypeUtilities.h>
+#include "TypeUtilities.h"
 #include <iostream>
+#include <iterator>
 #include <utility>
 
+#include "AlignedAllocator.h"
+
 namespace ndtech {
 
+  // Contiguous run of one column's values.  Stands in for std::span, which needs C++20.
+  template <typename T>
+  struct ColumnSpan {
+    T*        m_data = nullptr;
+    size_t    m_size = 0;
+
+    T* data() const {
+      return m_data;
+    }
+
+    size_t size() const {
+      return m_size;
+    }
+
+    bool empty() const {
+      return m_size == 0;
+    }
+
+    T* begin() const {
+      return m_data;
+    }
+
+    T* end() const {
+      return m_data + m_size;
+    }
+
+    T& operator[](size_t index) const {
+      return m_data[index];
+    }
+  };
+
+  // Struct-of-arrays store: one dense column per item type plus a column of ids, and a
+  // hash index from id to slot.  Slots stay packed, removal moves the last row into the
+  // hole, so every operation is O(1) and each column can be walked contiguously.
   template <typename IdType, typename... ItemType>
   struct MultiItemStore {
 
+    // Every column starts on a cache line, so batch kernels over a View can use aligned
+    // vector loads from the first element
+    static constexpr size_t ColumnAlignment = 64;
+
+    template <typename ColumnType>
+    using Column = std::vector<ColumnType, AlignedAllocator<ColumnType, ColumnAlignment>>;
+
     using ItemIndexSequence = std::index_sequence_for<ItemType...>;
+    // Covers the id column as well as the item columns
+    using ColumnIndexSequence = std::index_sequence_for<IdType, ItemType...>;
+    enum class ActionType : uint8_t {
+      AddOrUpdate,
+      Remove
+    };
+
+    using ItemAction = std::tuple<ActionType, IdType, ItemType...>;
+
+    // Adds and removes that reach the apply loop together through Commit, and are applied
+    // in one pass under m_itemsMutex, so readers see all of them or none
+    struct Batch {
+      void AddItem(IdType key, ItemType... value) {
+        m_itemActions.emplace_back(ActionType::AddOrUpdate, std::move(key), std::move(value)...);
+      }
+
+      void RemoveItem(IdType itemId) {
+        m_itemActions.emplace_back(ActionType::Remove, std::move(itemId), ItemType{}...);
+      }
 
-    std::tuple<std::vector<IdType>, std::vector<ItemType>...> m_items;
+      std::vector<ItemAction> m_itemActions;
+    };
+
+    // Index of the first column holding ColumnType, the id column being column 0
+    template <typename ColumnType>
+    static constexpr size_t ColumnIndex = TypeUtilities::Impl::IndexOfImpl<0, ColumnType, TypeUtilities::Typelist<IdType, ItemType...>>::value;
+
+    // Read-only spans over some of the columns.  The view holds m_itemsMutex, so the
+    // columns stay as they are, and the apply loop waits, until it is destroyed.
+    template <typename... ColumnTypes>
+    struct ColumnView {
+      std::unique_lock<boost::fibers::mutex>        m_lock;
+      std::tuple<ColumnSpan<const ColumnTypes>...>  m_columns;
+      size_t                                        m_size = 0;
+
+      ColumnView(std::unique_lock<boost::fibers::mutex> lock, std::tuple<ColumnSpan<const ColumnTypes>...> columns, size_t size)
+        : m_lock(std::move(lock)),
+        m_columns(columns),
+        m_size(size) {
+      }
+
+      size_t Size() const {
+        return m_size;
+      }
+
+      template <typename ColumnType>
+      ColumnSpan<const ColumnType> Get() const {
+        return std::get<ColumnSpan<const ColumnType>>(m_columns);
+      }
+
+      template <size_t Index>
+      auto Get() const {
+        return std::get<Index>(m_columns);
+      }
+    };
+
+    std::tuple<Column<IdType>, Column<ItemType>...> m_items;
+    std::unordered_map<IdType, size_t> m_slots;
     boost::fibers::mutex m_itemsMutex;
     boost::fibers::condition_variable m_itemsCV;
 
-    std::vector<std::tuple<std::string, IdType, ItemType...>> m_itemActions;
+    std::vector<ItemAction> m_itemActions;
     boost::fibers::mutex m_itemActionsMutex;
+    boost::fibers::condition_variable m_itemActionsCV;
 
     bool m_running = true;
 
@@ -32,15 +133,16 @@ namespace ndtech {
 
     MultiItemStore(const MultiItemStore<IdType, ItemType...>& other) {
       this->m_items = other.m_items;
+      this->m_slots = other.m_slots;
       this->m_itemActions = other.m_itemActions;
     }
 
     MultiItemStore& operator=(const MultiItemStore<IdType, ItemType...>& rhs) {
-      MultiItemStore lhs;
-      lhs.m_items = rhs.m_items;
-      lhs.m_itemActions = rhs.m_itemActions;
+      this->m_items = rhs.m_items;
+      this->m_slots = rhs.m_slots;
+      this->m_itemActions = rhs.m_itemActions;
 
-      return lhs;
+      return *this;
     }
 
 
@@ -48,185 +150,188 @@ namespace ndtech {
       fiber = boost::fibers::fiber(&MultiItemStore::Run, this);
     }
 
-    template<size_t Index>
-    void AddTupleItemToVectorFromTupleByIndex(std::tuple<ItemType...> tuple, std::tuple<std::vector<ItemType>...>& tupleOfItemTypeVectors) {
-      std::get<Index>(tupleOfItemTypeVectors).push_back(std::get<Index>(tuple));
-    }
-
+    // The action tuple leads with the action type, so column Index is at Index + 1
     template <size_t... Index>
-    void AddTupleToVectorsByIndex(std::tuple<IdType, ItemType...> tuple, std::tuple<std::vector<IdType>, std::vector<ItemType>...>& tupleOfItemTypeVectors, std::index_sequence<Index...>) {
-      (AddTupleItemToVectorFromTupleByIndex<Index>(tuple, tupleOfItemTypeVectors), ...);
-    }
-
-    void AddTupleToVectors(std::tuple<IdType, ItemType...> tuple, std::tuple<std::vector<IdType>, std::vector<ItemType>...>& tupleOfItemTypeVectors) {
-
-      using IndexSequenceForItemType = std::index_sequence_for<IdType, ItemType...>;
-      AddTupleToVectorsByIndex(tuple, tupleOfItemTypeVectors, IndexSequenceForItemType{});
-    }
-
-    template<size_t Index>
-    void UpdateTupleItemToVectorFromTupleByIndex(std::tuple<ItemType...> tuple, std::tuple<std::vector<ItemType>...>& tupleOfItemTypeVectors, size_t idIndex) {
-      std::get<Index>(tupleOfItemTypeVectors).at(idIndex) = std::get<Index>(tuple);
+    void PushBackColumns(ItemAction& itemAction, std::index_sequence<Index...>) {
+      (std::get<Index>(m_items).push_back(std::move(std::get<Index + 1>(itemAction))), ...);
     }
 
     template <size_t... Index>
-    void UpdateTupleToVectorsByIndex(std::tuple<IdType, ItemType...> tuple, std::tuple<std::vector<IdType>, std::vector<ItemType>...>& tupleOfItemTypeVectors, std::index_sequence<Index...>, size_t idIndex) {
-      (UpdateTupleItemToVectorFromTupleByIndex<Index>(tuple, tupleOfItemTypeVectors, idIndex), ...);
+    void AssignColumns(size_t slot, ItemAction& itemAction, std::index_sequence<Index...>) {
+      ((std::get<Index>(m_items)[slot] = std::move(std::get<Index + 1>(itemAction))), ...);
     }
 
-    void UpdateTupleToVectors(std::tuple<IdType, ItemType...> tuple, std::tuple<std::vector<IdType>, std::vector<ItemType>...>& tupleOfItemTypeVectors, size_t idIndex) {
-
-      using IndexSequenceForItemType = std::index_sequence_for<IdType, ItemType...>;
-      UpdateTupleToVectorsByIndex(tuple, tupleOfItemTypeVectors, IndexSequenceForItemType{}, idIndex);
+    template <size_t... Index>
+    void MoveSlot(size_t fromSlot, size_t toSlot, std::index_sequence<Index...>) {
+      ((std::get<Index>(m_items)[toSlot] = std::move(std::get<Index>(m_items)[fromSlot])), ...);
     }
 
-    template<size_t Index>
-    void RemoveFromTupleOfVectorsByIndexImpl(size_t idIndex, std::tuple<std::vector<ItemType>...>& tupleOfItemTypeVectors) {
-      std::get<Index>(tupleOfItemTypeVectors).erase(std::get<Index>(tupleOfItemTypeVectors).begin() + idIndex);
+    template <size_t... Index>
+    void PopBackColumns(std::index_sequence<Index...>) {
+      (std::get<Index>(m_items).pop_back(), ...);
     }
 
+    // Skips the id column
     template <size_t... Index>
-    void RemoveFromTupleOfVectorsByIndex(size_t idIndex, std::tuple<std::vector<IdType>, std::vector<ItemType>...>& tupleOfItemTypeVectors, std::index_sequence<Index...>) {
-      (RemoveFromTupleOfVectorsByIndexImpl<Index>(idIndex, tupleOfItemTypeVectors), ...);
+    std::tuple<ItemType...> MakeTupleFromColumns(size_t slot, std::index_sequence<Index...>) {
+      return std::make_tuple(std::get<Index + 1>(m_items)[slot]...);
     }
 
-    void RemoveFromTupleOfVectors(size_t idIndex, std::tuple<std::vector<IdType>, std::vector<ItemType>...>& tupleOfItemTypeVectors) {
+    void ApplyAddOrUpdate(ItemAction& itemAction) {
+      IdType itemActionId = std::get<1>(itemAction);
+      auto foundSlot = m_slots.find(itemActionId);
 
-      using IndexSequenceForItemType = std::index_sequence_for<IdType, ItemType...>;
-      RemoveFromTupleOfVectorsByIndex(idIndex, tupleOfItemTypeVectors, IndexSequenceForItemType{});
+      if (foundSlot == m_slots.end()) {
+        m_slots.emplace(std::move(itemActionId), std::get<0>(m_items).size());
+        PushBackColumns(itemAction, ColumnIndexSequence{});
+      }
+      else {
+        AssignColumns(foundSlot->second, itemAction, ColumnIndexSequence{});
+      }
     }
 
+    void ApplyRemove(const IdType& itemActionId) {
+      auto foundSlot = m_slots.find(itemActionId);
+      if (foundSlot == m_slots.end()) {
+        return;
+      }
 
-    //template<size_t Index, typename... ItemType>
-    //std::tuple<IdType, ItemType...>  MakeTupleFromVectorsUsingIndexImpl(size_t idIndex, std::tuple<std::vector<IdType>, std::vector<ItemType>...>& tupleOfItemTypeVectors) {
-    //  auto retVal = std::make_tuple(std::get<Index>(tupleOfItemTypeVectors)[idIndex]);
-    //  return retVal;
-    //}
+      size_t slot = foundSlot->second;
+      size_t lastSlot = std::get<0>(m_items).size() - 1;
+      m_slots.erase(foundSlot);
 
-    template <size_t... Index>
-    std::tuple<IdType, ItemType...>  MakeTupleFromVectorsUsingIndex(size_t idIndex, std::tuple<std::vector<IdType>, std::vector<ItemType>...>& tupleOfItemTypeVectors, std::index_sequence<Index...>) {
-      //auto retVal = (MakeTupleFromVectorsUsingIndexImpl<Index>(idIndex, tupleOfItemTypeVectors), ...);
-      auto retVal = std::make_tuple(std::get<Index>(tupleOfItemTypeVectors)[idIndex]...);
-      return retVal;
-    }
-
-    std::tuple<IdType, ItemType...> MakeTupleFromVectors(size_t idIndex, std::tuple<std::vector<IdType>, std::vector<ItemType>...>& tupleOfItemTypeVectors) {
-      using IndexSequenceForItemType = std::index_sequence_for<IdType, ItemType...>;
-      return MakeTupleFromVectorsUsingIndex(idIndex, tupleOfItemTypeVectors, IndexSequenceForItemType{});
+      // Fill the hole with the last row and point its id at the new slot
+      if (slot != lastSlot) {
+        MoveSlot(lastSlot, slot, ColumnIndexSequence{});
+        m_slots[std::get<0>(m_items)[slot]] = slot;
+      }
+      PopBackColumns(ColumnIndexSequence{});
     }
 
+    // Sleeps until actions arrive, then applies all of them under one lock of m_itemsMutex
     void Run() {
-      while (m_running) {
-        {
-          std::lock_guard<boost::fibers::mutex> lock(m_itemActionsMutex);
-          for (auto itemAction : m_itemActions) {
-            std::string transactionType = std::get<0>(itemAction);
-            IdType itemActionId = std::get<1>(itemAction);
-
-            if (transactionType == "am") {
-              std::lock_guard<boost::fibers::mutex> itemsLock(m_itemsMutex);
-
-              // Get the item Ids
-              auto ids = std::get<0>(m_items);
-
-              // Then check if the id of the itemActionId is in ids
-              auto foundId = std::find_if(
-                ids.begin(),
-                ids.end(),
-                [itemActionId](auto testId) {
-                  return itemActionId == testId;
-                });
-
-              auto tupleWithoutTransactionType = ndtech::TypeUtilities::tail<1>(itemAction);
-
-              if (foundId == ids.end()) {
-                // Add the new item to the item actions
-                AddTupleToVectors(tupleWithoutTransactionType, m_items);
-              }
-              else {
-                // Update the existing records
-
-                // First get the index of the record we found
-                size_t index = std::distance(ids.begin(), foundId);
-
-                // Now update all of the items based on the passed in tuple
-                UpdateTupleToVectors(tupleWithoutTransactionType, m_items, index);
-              }
-
-              m_itemsCV.notify_all();
-            }
-
-            else if (transactionType == "rm") {
-              std::lock_guard<boost::fibers::mutex> itemsLock(m_itemsMutex);
-
-              // Get the item Ids
-              auto ids = std::get<0>(m_items);
-
-              // Then check if the id of the itemActionId is in ids
-              auto foundId = std::find_if(
-                ids.begin(),
-                ids.end(),
-                [itemActionId](auto testId) {
-                  return itemActionId == testId;
-                });
+      std::vector<ItemAction> itemActions;
 
-              if (foundId != ids.end()) {
-                // First get the index of the record we found
-                size_t index = std::distance(ids.begin(), foundId);
+      while (true) {
+        {
+          std::unique_lock<boost::fibers::mutex> lock(m_itemActionsMutex);
+          m_itemActionsCV.wait(lock, [this]() { return !m_running || !m_itemActions.empty(); });
+          if (m_itemActions.empty()) {
+            return;
+          }
+          itemActions.swap(m_itemActions);
+        }
 
-                // Remove the item from m_items
-                RemoveFromTupleOfVectors(index, m_items);
-              }
+        {
+          std::lock_guard<boost::fibers::mutex> itemsLock(m_itemsMutex);
+          for (auto& itemAction : itemActions) {
+            ActionType actionType = std::get<0>(itemAction);
 
-              m_itemsCV.notify_all();
+            if (actionType == ActionType::AddOrUpdate) {
+              ApplyAddOrUpdate(itemAction);
+            }
+            else if (actionType == ActionType::Remove) {
+              ApplyRemove(std::get<1>(itemAction));
             }
           }
-
-          m_itemActions.clear();
-
         }
+        m_itemsCV.notify_all();
 
-        boost::this_fiber::yield();
+        itemActions.clear();
       }
     }
 
+    // Actions already added are still applied before Run returns
     void Stop() {
+      std::lock_guard<boost::fibers::mutex> lock(m_itemActionsMutex);
       m_running = false;
+      m_itemActionsCV.notify_all();
     }
 
     void AddItem(IdType key, ItemType... value) {
       std::lock_guard<boost::fibers::mutex> lock(m_itemActionsMutex);
-      m_itemActions.push_back(std::make_tuple("am", key, value...));
-      m_itemsCV.notify_all();
+      m_itemActions.emplace_back(ActionType::AddOrUpdate, std::move(key), std::move(value)...);
+      m_itemActionsCV.notify_one();
     }
 
     void RemoveItem(IdType itemId) {
       std::lock_guard<boost::fibers::mutex> lock(m_itemActionsMutex);
-      m_itemActions.push_back(std::make_tuple("rm", itemId, ItemType{}...));
+      m_itemActions.emplace_back(ActionType::Remove, std::move(itemId), ItemType{}...);
+      m_itemActionsCV.notify_one();
     }
 
+    // Queues every action in batch under one lock and wakes the apply loop once
+    void Commit(Batch&& batch) {
+      if (batch.m_itemActions.empty()) {
+        return;
+      }
+
+      std::lock_guard<boost::fibers::mutex> lock(m_itemActionsMutex);
+      if (m_itemActions.empty()) {
+        m_itemActions.swap(batch.m_itemActions);
+      }
+      else {
+        std::move(batch.m_itemActions.begin(), batch.m_itemActions.end(), std::back_inserter(m_itemActions));
+      }
+      m_itemActionsCV.notify_one();
+    }
+
+    // Waits for the item to be added
     std::tuple<ItemType...> GetItem(IdType itemId) {
       std::unique_lock<boost::fibers::mutex> lock(m_itemsMutex);
-      auto keys = std::get<0>(m_items);
-      auto iter = std::find(keys.begin(), keys.end(), itemId);
-      while (iter == keys.end()) {
+      auto foundSlot = m_slots.find(itemId);
+      while (foundSlot == m_slots.end()) {
         m_itemsCV.wait(lock);
+        foundSlot = m_slots.find(itemId);
       }
 
-      size_t index = std::distance(keys.begin(), iter);
-      return ndtech::TypeUtilities::tail<1>(MakeTupleFromVectors(index, m_items));
+      return MakeTupleFromColumns(foundSlot->second, ItemIndexSequence{});
     }
 
     bool ItemExists(IdType itemName) {
 
       std::unique_lock<boost::fibers::mutex> lock(m_itemsMutex);
-      if (m_items.find(itemName) != m_items.end()) {
+      if (m_slots.find(itemName) != m_slots.end()) {
         return true;
       }
       return false;
 
     }
 
+    // Columns are picked by type; an item type that appears twice gives its first column
+    template <typename... ColumnTypes>
+    ColumnView<ColumnTypes...> View() {
+      static_assert(((ColumnIndex<ColumnTypes> != size_t(-1)) && ...), "View of a type that is not a column of this store");
+
+      // The spans are only taken once the lock is held
+      std::unique_lock<boost::fibers::mutex> lock(m_itemsMutex);
+      return ColumnView<ColumnTypes...>(std::move(lock), std::make_tuple(MakeColumnSpan<ColumnTypes>()...), std::get<0>(m_items).size());
+    }
+
+    // Calls function once per column, ids first, with a ColumnSpan over the whole column,
+    // all under one lock of m_itemsMutex
+    template <typename FunctionType>
+    void ForEachColumn(FunctionType&& function) {
+      std::unique_lock<boost::fibers::mutex> lock(m_itemsMutex);
+      ForEachColumnByIndex(function, ColumnIndexSequence{});
+    }
+
+    template <typename ColumnType>
+    ColumnSpan<const ColumnType> MakeColumnSpan() {
+      auto& column = std::get<ColumnIndex<ColumnType>>(m_items);
+      return ColumnSpan<const ColumnType>{ column.data(), column.size() };
+    }
+
+    template <typename FunctionType, size_t... Index>
+    void ForEachColumnByIndex(FunctionType& function, std::index_sequence<Index...>) {
+      (function(ColumnSpan<const typename std::tuple_element_t<Index, decltype(m_items)>::value_type>{ std::get<Index>(m_items).data(), std::get<Index>(m_items).size() }), ...);
+    }
+
+    size_t Size() {
+      std::unique_lock<boost::fibers::mutex> lock(m_itemsMutex);
+      return std::get<0>(m_items).size();
+    }
+
   };
 
 }
\ No newline at end of file
@@ -2,95 +2,635 @@
 
 #include "pch.h"
 
-#include <map>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <thread>
 #include <vector>
 #include <tuple>
 #include <boost/fiber/all.hpp>
 
+#include "ItemMaps.h"
+
 namespace ndtech {
 
-  template <typename ItemType, typename NameType = std::string>
+  // Counter split across cache lines, so threads counting at once rarely share a line
+  struct StripedCounter {
+
+    static constexpr size_t Stripes = 16;
+
+    void Add(uint64_t count = 1) {
+      m_stripes[StripeIndex()].m_count.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    uint64_t Sum() const {
+      uint64_t sum = 0;
+      for (const Stripe& stripe : m_stripes) {
+        sum += stripe.m_count.load(std::memory_order_relaxed);
+      }
+      return sum;
+    }
+
+  private:
+    struct alignas(64) Stripe {
+      std::atomic<uint64_t>   m_count{ 0 };
+    };
+
+    static size_t StripeIndex() {
+      thread_local size_t t_stripe = std::hash<std::thread::id>{}(std::this_thread::get_id()) % Stripes;
+      return t_stripe;
+    }
+
+    Stripe    m_stripes[Stripes];
+  };
+
+  struct NamedItemStoreStats {
+    uint64_t    m_hits = 0;
+    uint64_t    m_misses = 0;
+    uint64_t    m_evictions = 0;
+    // Bytes held, as measured by the size function; 0 unless a budget is set
+    uint64_t    m_bytes = 0;
+  };
+
+  // ItemMapType picks the backend: OrderedItemMap works with any ordered key, and
+  // ShardedItemMap gives lock-free lookups for keys with a std::hash.
+  template <typename ItemType, typename NameType = std::string, template <typename, typename> class ItemMapType = OrderedItemMap>
   struct NamedItemStore {
 
-    std::map<NameType, ItemType> m_items;
+    // Items are handed out immutable behind a shared_ptr so readers can share them
+    // without copying
+    using ItemPointer = std::shared_ptr<const ItemType>;
+    using SizeFunction = std::function<size_t(const ItemType&)>;
+
+    // What the map holds for each item.  A backend may hold several references to one
+    // entry, in shard copies or retired snapshots, so whether an item is in use is counted
+    // separately in m_pins.
+    struct StoredItem {
+      explicit StoredItem(ItemType&& item)
+        : m_item(std::move(item)) {
+      }
+
+      const ItemType                    m_item;
+      // m_useClock when the item was added or last looked up
+      std::atomic<uint64_t>             m_lastUse{ 0 };
+      // ItemPointers handed out while a byte budget is set that are still held
+      std::atomic<uint32_t>             m_pins{ 0 };
+      // Only the apply loop uses it
+      size_t                            m_bytes = 0;
+    };
+
+    using StoredPointer = std::shared_ptr<StoredItem>;
+    using ItemMap = ItemMapType<NameType, StoredPointer>;
+
+    enum class ActionType : uint8_t {
+      Add,
+      Remove
+    };
+
+    using ItemAction = std::tuple<NameType, StoredPointer, ActionType>;
+
+    // Adds and removes that reach the apply loop together through Commit.  Every action
+    // queued before the loop wakes is applied in one pass under one lock, and lock-free
+    // readers redo a read that overlapped the pass's changes, so no lookup sees part of a
+    // batch and TryGetItems sees all of it or none.
+    struct Batch {
+      void AddItem(NameType key, ItemType value) {
+        m_itemActions.emplace_back(std::move(key), std::make_shared<StoredItem>(std::move(value)), ActionType::Add);
+      }
+
+      void RemoveItem(NameType itemName) {
+        m_itemActions.emplace_back(std::move(itemName), nullptr, ActionType::Remove);
+      }
+
+      std::vector<ItemAction> m_itemActions;
+    };
+
+    ItemMap m_items;
     boost::fibers::mutex m_itemsMutex;
     boost::fibers::condition_variable m_itemsCV;
 
-    std::vector<std::tuple<NameType, ItemType, std::string>> m_itemActions;
+    // Names whose GetOrCreate factory is running, or whose item it made has not been
+    // applied yet; guarded by m_itemsMutex
+    std::vector<std::pair<NameType, StoredPointer>> m_creations;
+
+    std::vector<ItemAction> m_itemActions;
     boost::fibers::mutex m_itemActionsMutex;
+    boost::fibers::condition_variable m_itemActionsCV;
 
     bool m_running = true;
 
+    // Odd while the apply loop is changing m_items, see BeginChange
+    std::atomic<uint64_t> m_applySequence{ 0 };
+
+    // Each apply pass publishes a version.  Actions queued now will be visible from
+    // m_pendingVersion on; it is guarded by m_itemActionsMutex.
+    uint64_t m_pendingVersion = 1;
+    std::atomic<uint64_t> m_version{ 0 };
+
+    // Eviction settings and state, guarded by m_itemsMutex.  m_byteBudget of 0 means
+    // items are kept until they are removed.
+    size_t m_byteBudget = 0;
+    SizeFunction m_sizeOf;
+    uint64_t m_bytes = 0;
+    // Readers check it without the lock to decide whether to pin what they hand out
+    std::atomic<bool> m_pinItems{ false };
+
+    // Advanced by the apply loop for every item it adds
+    std::atomic<uint64_t> m_useClock{ 1 };
+    StripedCounter m_hits;
+    StripedCounter m_misses;
+    std::atomic<uint64_t> m_evictions{ 0 };
+
 
 
     void RunOn(boost::fibers::fiber& fiber) {
       fiber = boost::fibers::fiber(&NamedItemStore::Run, this);
     }
 
+    // Sleeps until actions arrive, then takes the whole pending vector in one swap and
+    // applies it under a single lock of m_itemsMutex.  The two vectors trade places every
+    // pass, so once both have grown to the working size nothing is allocated.
     void Run() {
-      while (m_running) {
+      std::vector<ItemAction> itemActions;
+      uint64_t version = 0;
+
+      std::vector<std::pair<uint64_t, NameType>> evictionCandidates;
+
+      while (true) {
         {
-          std::lock_guard<boost::fibers::mutex> lock(m_itemActionsMutex);
-          for (auto itemAction : m_itemActions) {
-            if (std::get<2>(itemAction) == "a") {
-              std::lock_guard<boost::fibers::mutex> itemsLock(m_itemsMutex);
-              m_items.insert_or_assign(std::get<0>(itemAction), std::get<1>(itemAction));
-              m_itemsCV.notify_all();
-              //std::cout << "NamedItemStore threadId = " << std::this_thread::get_id() << ": added item itemName = " << std::get<0>(itemAction) << " itemValue = " << std::get<1>(itemAction) << std::endl;
-            }
-            else if (std::get<2>(itemAction) == "r") {
-              std::lock_guard<boost::fibers::mutex> itemsLock(m_itemsMutex);
-              auto foundItem = m_items.find(std::get<0>(itemAction));
-              if (foundItem != m_items.end()) {
-                m_items.erase(foundItem);
-                m_itemsCV.notify_all();
-                //std::cout << "NamedItemStore threadId = " << std::this_thread::get_id() << ": removed item itemName = " << std::get<0>(itemAction) << std::endl;
+          std::unique_lock<boost::fibers::mutex> lock(m_itemActionsMutex);
+          m_itemActionsCV.wait(lock, [this]() { return !m_running || !m_itemActions.empty(); });
+          if (m_itemActions.empty()) {
+            return;
+          }
+          itemActions.swap(m_itemActions);
+          version = m_pendingVersion++;
+        }
+
+        bool overBudget = false;
+        {
+          std::lock_guard<boost::fibers::mutex> itemsLock(m_itemsMutex);
+
+          // Everything about an added item that does not touch m_items, including the
+          // caller's size function, is done before lock-free readers are held off
+          for (auto& itemAction : itemActions) {
+            if (std::get<2>(itemAction) == ActionType::Add) {
+              FinishCreation(std::get<0>(itemAction));
+              if (m_byteBudget > 0) {
+                SizeItem(*std::get<1>(itemAction));
               }
-              else {
-                //std::cout << "NamedItemStore threadId = " << std::this_thread::get_id() << ": unable to remove item itemName = " << std::get<0>(itemAction) << " because it does not exist." << std::endl;
+              std::get<1>(itemAction)->m_lastUse.store(m_useClock.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            }
+          }
+
+          BeginChange();
+          for (auto& itemAction : itemActions) {
+            if (m_byteBudget > 0) {
+              UnaccountItem(std::get<0>(itemAction));
+            }
+
+            if (std::get<2>(itemAction) == ActionType::Add) {
+              if (m_byteBudget > 0) {
+                AccountItem(*std::get<1>(itemAction));
               }
+              m_items.Assign(std::move(std::get<0>(itemAction)), std::move(std::get<1>(itemAction)));
+            }
+            else if (std::get<2>(itemAction) == ActionType::Remove) {
+              m_items.Erase(std::get<0>(itemAction));
             }
           }
+          EndChange();
+
+          overBudget = m_byteBudget > 0 && m_bytes > m_byteBudget;
+          if (!overBudget) {
+            PublishVersion(version);
+          }
+        }
 
-          m_itemActions.clear();
+        // Only this loop changes m_items, so it can pick the victims without the lock and
+        // hold it just to erase them
+        if (overBudget) {
+          FindEvictionCandidates(evictionCandidates);
 
+          std::lock_guard<boost::fibers::mutex> itemsLock(m_itemsMutex);
+          Evict(evictionCandidates);
+          PublishVersion(version);
         }
+        m_itemsCV.notify_all();
 
-        boost::this_fiber::yield();
+        itemActions.clear();
       }
     }
 
+    // Actions already added are still applied before Run returns
     void Stop() {
+      std::lock_guard<boost::fibers::mutex> lock(m_itemActionsMutex);
       m_running = false;
+      m_itemActionsCV.notify_all();
+    }
+
+    // Once the items measured by sizeOf pass byteBudget, the apply loop evicts the least
+    // recently looked up items that are not in use until they fit in seven eighths of it.
+    // Recency is a clock that only the apply loop advances, so a reader stores to an item
+    // it looks up at most once per tick.  Eviction picks and sorts its victims without the
+    // lock readers of a locking backend take, and holds it only to erase them.
+    // An evicted item is simply gone, so a store with a budget should be read through
+    // GetOrCreate, TryGetItem or GetItemFor rather than GetItem.  Items are only pinned
+    // while a budget is set, so set it before handing any out.
+    void SetByteBudget(size_t byteBudget, SizeFunction sizeOf) {
+      std::lock_guard<boost::fibers::mutex> lock(m_itemsMutex);
+      m_byteBudget = byteBudget;
+      m_sizeOf = std::move(sizeOf);
+      m_pinItems.store(m_byteBudget > 0, std::memory_order_relaxed);
+
+      m_bytes = 0;
+      if (m_byteBudget > 0) {
+        m_items.ForEach([this](const NameType&, const StoredPointer& storedItem) {
+          SizeItem(*storedItem);
+          AccountItem(*storedItem);
+        });
+      }
+    }
+
+    NamedItemStoreStats Stats() {
+      NamedItemStoreStats stats;
+      stats.m_hits = m_hits.Sum();
+      stats.m_misses = m_misses.Sum();
+      stats.m_evictions = m_evictions.load(std::memory_order_relaxed);
+
+      std::lock_guard<boost::fibers::mutex> lock(m_itemsMutex);
+      stats.m_bytes = m_bytes;
+      return stats;
+    }
+
+    // Writes return the version from which they are visible, for WaitForVersion
+    uint64_t AddItem(NameType key, ItemType value) {
+      return AddStored(std::move(key), std::make_shared<StoredItem>(std::move(value)));
     }
 
-    void AddItem(NameType key, ItemType value) {
+    uint64_t RemoveItem(NameType itemName) {
       std::lock_guard<boost::fibers::mutex> lock(m_itemActionsMutex);
-      m_itemActions.push_back(std::make_tuple(key, value, "a"));
-      m_itemsCV.notify_all();
+      m_itemActions.emplace_back(std::move(itemName), nullptr, ActionType::Remove);
+      m_itemActionsCV.notify_one();
+      return m_pendingVersion;
     }
 
-    void RemoveItem(NameType itemName) {
+    // Queues every action in batch under one lock and wakes the apply loop once
+    uint64_t Commit(Batch&& batch) {
       std::lock_guard<boost::fibers::mutex> lock(m_itemActionsMutex);
-      m_itemActions.push_back(std::make_tuple(itemName, "", "r"));
+      if (batch.m_itemActions.empty()) {
+        return m_pendingVersion - 1;
+      }
+
+      if (m_itemActions.empty()) {
+        m_itemActions.swap(batch.m_itemActions);
+      }
+      else {
+        std::move(batch.m_itemActions.begin(), batch.m_itemActions.end(), std::back_inserter(m_itemActions));
+      }
+      m_itemActionsCV.notify_one();
+      return m_pendingVersion;
+    }
+
+    // Latest version the apply loop has published
+    uint64_t Version() const {
+      return m_version.load(std::memory_order_acquire);
+    }
+
+    // Blocks until every write that returned version or less is visible to readers
+    void WaitForVersion(uint64_t version) {
+      if (Version() >= version) {
+        return;
+      }
+
+      std::unique_lock<boost::fibers::mutex> lock(m_itemsMutex);
+      m_itemsCV.wait(lock, [this, version]() { return Version() >= version; });
+    }
+
+    // Waits for the item to be added.  With a lock-free backend an item that is already
+    // there is read without touching m_itemsMutex.
+    ItemType GetItem(const NameType& itemName) {
+      return *GetShared(itemName);
+    }
+
+    // Like GetItem, but hands out the stored item itself rather than a copy.  The item
+    // stays alive for as long as the pointer is held, even after it is removed, replaced
+    // or evicted, and is never evicted while the pointer is held.
+    ItemPointer GetShared(const NameType& itemName) {
+      if (ItemPointer item = Lookup(itemName)) {
+        return item;
+      }
+
+      std::unique_lock<boost::fibers::mutex> lock(m_itemsMutex);
+      ItemPointer item;
+      while (!(item = Find(itemName))) {
+        m_itemsCV.wait(lock);
+      }
+      return item;
+    }
+
+    // Never waits.  Returns nullptr if the item has not been added.
+    ItemPointer TryGetItem(const NameType& itemName) {
+      return Lookup(itemName);
+    }
+
+    // Looks up several items from the same state of the store.  Items that have not been
+    // added come back as nullptr.
+    std::vector<ItemPointer> TryGetItems(const std::vector<NameType>& itemNames) {
+      std::vector<ItemPointer> items(itemNames.size());
+      // A snapshot backend answers every name from the same version
+      auto findItems = [&]() {
+        m_items.Read([&](const auto& view) {
+          for (size_t index = 0; index < itemNames.size(); index++) {
+            items[index] = FindIn(view, itemNames[index]);
+          }
+        });
+      };
+
+      bool readOutsideApply = false;
+      if constexpr (ItemMap::LockFreeReads) {
+        readOutsideApply = ReadOutsideApply(findItems);
+      }
+
+      if (!readOutsideApply) {
+        std::lock_guard<boost::fibers::mutex> lock(m_itemsMutex);
+        findItems();
+      }
+
+      for (const ItemPointer& item : items) {
+        (item != nullptr ? m_hits : m_misses).Add();
+      }
+      return items;
+    }
+
+    // Returns nullptr if the item has not been added within timeout
+    template <typename Rep, typename Period>
+    ItemPointer GetItemFor(const NameType& itemName, std::chrono::duration<Rep, Period> timeout) {
+      auto deadline = std::chrono::steady_clock::now() + timeout;
+
+      if (ItemPointer item = Lookup(itemName)) {
+        return item;
+      }
+
+      std::unique_lock<boost::fibers::mutex> lock(m_itemsMutex);
+      ItemPointer item;
+      while (!(item = Find(itemName))) {
+        if (m_itemsCV.wait_until(lock, deadline) == boost::fibers::cv_status::timeout) {
+          return Find(itemName);
+        }
+      }
+      return item;
     }
 
-    ItemType GetItem(NameType itemName) {
+    // Returns the item, calling factory to make it if it has not been added.  Callers that
+    // arrive while another caller's factory for the same name is running wait for its
+    // result, so factory runs once per name; if it throws, the exception goes to its caller
+    // and the next waiter runs its own factory.  factory must not look up the same name.
+    template <typename FactoryType>
+    ItemPointer GetOrCreate(const NameType& itemName, FactoryType&& factory) {
+      if (ItemPointer item = Lookup(itemName)) {
+        return item;
+      }
+
       std::unique_lock<boost::fibers::mutex> lock(m_itemsMutex);
-      while (m_items.find(itemName) == m_items.end()) {
+      while (true) {
+        if (ItemPointer item = Find(itemName)) {
+          return item;
+        }
+
+        auto creation = FindCreation(itemName);
+        if (creation == m_creations.end()) {
+          break;
+        }
+        if (creation->second != nullptr) {
+          return Pin(creation->second);
+        }
         m_itemsCV.wait(lock);
       }
-      return (*(m_items.find(itemName))).second;
+
+      m_creations.emplace_back(itemName, nullptr);
+      lock.unlock();
+
+      StoredPointer storedItem;
+      try {
+        storedItem = std::make_shared<StoredItem>(factory());
+      }
+      catch (...) {
+        lock.lock();
+        m_creations.erase(FindCreation(itemName));
+        lock.unlock();
+        m_itemsCV.notify_all();
+        throw;
+      }
+
+      // Waiters take the item from m_creations until the apply loop has added it
+      lock.lock();
+      FindCreation(itemName)->second = storedItem;
+      lock.unlock();
+      m_itemsCV.notify_all();
+
+      ItemPointer item = Pin(storedItem);
+      AddStored(itemName, std::move(storedItem));
+      return item;
     }
 
-    bool ItemExists(NameType itemName) {
+    bool ItemExists(const NameType& itemName) {
+      if constexpr (ItemMap::LockFreeReads) {
+        bool exists = false;
+        if (ReadOutsideApply([&]() { exists = m_items.Contains(itemName); })) {
+          return exists;
+        }
+      }
 
       std::unique_lock<boost::fibers::mutex> lock(m_itemsMutex);
-      if (m_items.find(itemName) != m_items.end()) {
+      return m_items.Contains(itemName);
+    }
+
+    uint64_t AddStored(NameType key, StoredPointer storedItem) {
+      std::lock_guard<boost::fibers::mutex> lock(m_itemActionsMutex);
+      m_itemActions.emplace_back(std::move(key), std::move(storedItem), ActionType::Add);
+      m_itemActionsCV.notify_one();
+      return m_pendingVersion;
+    }
+
+    // First look at the map for a public lookup, counted as a hit or a miss
+    ItemPointer Lookup(const NameType& itemName) {
+      ItemPointer item;
+      bool readOutsideApply = false;
+
+      if constexpr (ItemMap::LockFreeReads) {
+        readOutsideApply = ReadOutsideApply([&]() { item = Find(itemName); });
+      }
+
+      if (!readOutsideApply) {
+        std::lock_guard<boost::fibers::mutex> lock(m_itemsMutex);
+        item = Find(itemName);
+      }
+
+      (item != nullptr ? m_hits : m_misses).Add();
+      return item;
+    }
+
+    // Runs a lock-free read and reports whether it can be trusted, which it cannot if the
+    // apply loop changed m_items at any point during it.  The caller then reads again under
+    // m_itemsMutex, which waits for the pass to finish.
+    template <typename ReadType>
+    bool ReadOutsideApply(ReadType&& read) {
+      if constexpr (ItemMap::ConsistentReads) {
+        read();
         return true;
       }
-      return false;
 
+      uint64_t sequence = m_applySequence.load(std::memory_order_acquire);
+      if ((sequence & 1) != 0) {
+        return false;
+      }
+
+      read();
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      return m_applySequence.load(std::memory_order_relaxed) == sequence;
+    }
+
+    // Needs m_itemsMutex unless the backend has lock-free reads
+    ItemPointer Find(const NameType& itemName) {
+      return FindIn(m_items, itemName);
+    }
+
+    // view is m_items or a view handed out by its Read
+    template <typename ViewType>
+    ItemPointer FindIn(const ViewType& view, const NameType& itemName) {
+      ItemPointer item;
+      view.Visit(itemName, [this, &item](const StoredPointer& storedItem) {
+        uint64_t useClock = m_useClock.load(std::memory_order_relaxed);
+        if (storedItem->m_lastUse.load(std::memory_order_relaxed) != useClock) {
+          storedItem->m_lastUse.store(useClock, std::memory_order_relaxed);
+        }
+        item = Pin(storedItem);
+      });
+      return item;
+    }
+
+    // Releases its pin when the last ItemPointer sharing it goes
+    struct Unpin {
+      StoredPointer m_storedItem;
+
+      void operator()(const ItemType*) {
+        m_storedItem->m_pins.fetch_sub(1, std::memory_order_release);
+      }
+    };
+
+    // Every ItemPointer the store hands out comes from here.  Without a budget it simply
+    // aliases the entry; with one it also pins it, at the cost of its own control block.
+    ItemPointer Pin(const StoredPointer& storedItem) {
+      if (!m_pinItems.load(std::memory_order_relaxed)) {
+        return ItemPointer(storedItem, &storedItem->m_item);
+      }
+
+      storedItem->m_pins.fetch_add(1, std::memory_order_relaxed);
+      return ItemPointer(&storedItem->m_item, Unpin{ storedItem });
+    }
+
+    // Needs m_itemsMutex
+    typename std::vector<std::pair<NameType, StoredPointer>>::iterator FindCreation(const NameType& itemName) {
+      return std::find_if(m_creations.begin(), m_creations.end(),
+        [&itemName](const std::pair<NameType, StoredPointer>& creation) { return creation.first == itemName; });
+    }
+
+    // Called by the apply loop, which holds m_itemsMutex, as the item for itemName is added
+    void FinishCreation(const NameType& itemName) {
+      if (m_creations.empty()) {
+        return;
+      }
+
+      auto creation = FindCreation(itemName);
+      if (creation != m_creations.end() && creation->second != nullptr) {
+        m_creations.erase(creation);
+      }
+    }
+
+    // The apply loop's byte accounting, under m_itemsMutex
+    void SizeItem(StoredItem& storedItem) {
+      storedItem.m_bytes = m_sizeOf(storedItem.m_item);
+    }
+
+    void AccountItem(const StoredItem& storedItem) {
+      m_bytes += storedItem.m_bytes;
+    }
+
+    void UnaccountItem(const NameType& itemName) {
+      m_items.VisitWritten(itemName, [this](const StoredPointer& storedItem) {
+        m_bytes -= storedItem->m_bytes;
+      });
+    }
+
+    // Needs m_itemsMutex
+    void PublishVersion(uint64_t version) {
+      m_items.Publish(version);
+      m_version.store(version, std::memory_order_release);
+    }
+
+    // The unpinned items, least recently looked up first.  Called by the apply loop without
+    // m_itemsMutex, so readers are not held off while it sorts.
+    void FindEvictionCandidates(std::vector<std::pair<uint64_t, NameType>>& candidates) {
+      candidates.clear();
+      m_items.ForEach([&candidates](const NameType& itemName, const StoredPointer& storedItem) {
+        if (storedItem->m_pins.load(std::memory_order_acquire) == 0) {
+          candidates.emplace_back(storedItem->m_lastUse.load(std::memory_order_relaxed), itemName);
+        }
+      });
+
+      std::sort(candidates.begin(), candidates.end(),
+        [](const std::pair<uint64_t, NameType>& left, const std::pair<uint64_t, NameType>& right) { return left.first < right.first; });
+    }
+
+    // Needs m_itemsMutex.  Returns whether anything was evicted.
+    bool Evict(const std::vector<std::pair<uint64_t, NameType>>& candidates) {
+      if (m_byteBudget == 0) {
+        return false;
+      }
+
+      uint64_t target = m_byteBudget - m_byteBudget / 8;
+      bool evicted = false;
+
+      // A candidate pinned since it was picked is kept.  An item looked up by a lock-free
+      // read while it is being evicted may still go; its reader keeps it alive, it is just
+      // no longer in the store.
+      BeginChange();
+      for (auto& candidate : candidates) {
+        if (m_bytes <= target) {
+          break;
+        }
+
+        bool pinned = false;
+        m_items.VisitWritten(candidate.second, [&pinned](const StoredPointer& storedItem) {
+          pinned = storedItem->m_pins.load(std::memory_order_acquire) != 0;
+        });
+        if (pinned) {
+          continue;
+        }
+
+        UnaccountItem(candidate.second);
+        m_items.Erase(candidate.second);
+        m_evictions.fetch_add(1, std::memory_order_relaxed);
+        evicted = true;
+      }
+      EndChange();
+      return evicted;
+    }
+
+    // Brackets the apply loop's changes to m_items.  A lock-free read that overlaps one is
+    // redone under m_itemsMutex, so the window is kept to the changes themselves.
+    void BeginChange() {
+      m_applySequence.fetch_add(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void EndChange() {
+      m_applySequence.fetch_add(1, std::memory_order_release);
     }
 
   };
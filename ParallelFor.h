@@ -0,0 +1,107 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+
+#include "Scheduler.h"
+
+namespace ndtech {
+
+  namespace ParallelForImpl {
+
+    // Shared with the helper tasks, which may only start after ParallelFor has returned
+    struct State {
+      std::atomic<size_t>         m_next{ 0 };
+      std::atomic<size_t>         m_finished{ 0 };
+      size_t                      m_count = 0;
+      // Only called for claimed indices, so never after ParallelFor has returned
+      void*                       m_function = nullptr;
+      void                        (*m_invoke)(void*, size_t) = nullptr;
+
+      std::mutex                  m_doneMutex;
+      std::condition_variable     m_doneConditionVariable;
+      bool                        m_done = false;
+      // The first exception a call threw, guarded by m_doneMutex
+      std::exception_ptr          m_exception;
+
+      // After a call throws, the indices nobody has claimed yet are abandoned and counted
+      // as finished, so only the calls already running are waited for
+      void RunClaimed() {
+        size_t index;
+        while ((index = m_next.fetch_add(1, std::memory_order_relaxed)) < m_count) {
+          size_t finished = 1;
+          try {
+            m_invoke(m_function, index);
+          }
+          catch (...) {
+            {
+              std::lock_guard<std::mutex> lock(m_doneMutex);
+              if (!m_exception) {
+                m_exception = std::current_exception();
+              }
+            }
+
+            size_t unclaimed = m_next.exchange(m_count, std::memory_order_relaxed);
+            if (unclaimed < m_count) {
+              finished += m_count - unclaimed;
+            }
+          }
+
+          if (m_finished.fetch_add(finished, std::memory_order_acq_rel) + finished == m_count) {
+            std::lock_guard<std::mutex> lock(m_doneMutex);
+            m_done = true;
+            m_doneConditionVariable.notify_all();
+          }
+        }
+      }
+    };
+
+  }
+
+  // Calls function(index) for every index below count and returns once every call has
+  // finished.  Up to one helper per scheduler worker is added to scheduler and the calling
+  // thread claims indices as well, so it only ever waits on calls already running
+  // elsewhere.  That makes it safe to call from a task on the same scheduler, nested or in
+  // SingleThread mode, where there are no workers and everything runs inline.  If a call
+  // throws, indices not yet started are skipped and the first exception is rethrown once
+  // the calls in flight have finished.
+  template <typename FunctionType>
+  void ParallelFor(Scheduler& scheduler, size_t count, FunctionType&& function) {
+    if (count == 0) {
+      return;
+    }
+
+    size_t helperCount = std::min(count - 1, scheduler.WorkerCount());
+    if (helperCount == 0) {
+      for (size_t index = 0; index < count; index++) {
+        function(index);
+      }
+      return;
+    }
+
+    auto state = std::make_shared<ParallelForImpl::State>();
+    state->m_count = count;
+    state->m_function = &function;
+    state->m_invoke = [](void* target, size_t index) {
+      (*static_cast<std::remove_reference_t<FunctionType>*>(target))(index);
+    };
+
+    for (size_t helper = 0; helper < helperCount; helper++) {
+      scheduler.AddTask([state]() { state->RunClaimed(); });
+    }
+
+    state->RunClaimed();
+
+    std::unique_lock<std::mutex> lock(state->m_doneMutex);
+    state->m_doneConditionVariable.wait(lock, [&state]() { return state->m_done; });
+    if (state->m_exception) {
+      std::rethrow_exception(state->m_exception);
+    }
+  }
+
+}
\ No newline at end of file
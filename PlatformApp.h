@@ -6,4 +6,8 @@
 
 #if NDTECH_ML
 #include "MagicLeapPlatformApp.h"
+#endif
+
+#if NDTECH_HEADLESS
+#include "HeadlessPlatformApp.h"
 #endif
\ No newline at end of file
@@ -1,29 +1,61 @@
 #include "pch.h"
 #include "Scheduler.h"
+#include "SchedulerTrace.h"
 
 #include <algorithm>
 
 namespace ndtech {
 
   Scheduler::Scheduler()
-    :m_wakeTime(system_clock::now()) {
+    : Scheduler(SchedulerSettings{}) {
+  }
+
+  Scheduler::Scheduler(SchedulerSettings settings)
+    : m_settings(settings),
+    m_wakeTime(Clock::now()) {
+
+    if (m_settings.m_useTimerWheel) {
+      m_repeatingTasksWheel = std::make_unique<TimerWheel<RepeatingTaskEntry>>(Clock::now(), m_settings.m_timerWheelResolution);
+    }
+
+    if (m_settings.m_mode == SchedulerMode::WorkStealing) {
+      m_workerPool = std::make_unique<WorkerPool>(m_settings.m_workerCount, &CountersFor(TaskLane::Background));
+    }
+    else if (m_settings.m_mode == SchedulerMode::Fibers) {
+      m_fiberPool = std::make_unique<FiberPool>(m_settings.m_workerCount, &CountersFor(TaskLane::Background));
+    }
+
+    // Only blocked producers need to hear about every task that leaves the queue
+    if (m_settings.m_maxQueuedTasks > 0 && m_settings.m_queueFullPolicy == QueueFullPolicy::Block) {
+      m_taskSlots.SetReleaseSignal(&m_capacitySignal);
+    }
+
     m_thread = std::thread{ &Scheduler::Run, this };
   }
 
   Scheduler::Scheduler(std::thread thread)
     : m_thread(std::move(thread)),
-    m_wakeTime(system_clock::now()) {
+    m_wakeTime(Clock::now()) {
   }
 
   void Scheduler::Run() {
     while (!m_done) {
 
-      std::unique_lock<std::mutex> lockGuard(m_waitMutex);
-
-      while (m_wakeTime > system_clock::now()) {
-        m_conditionVariable.wait_until(lockGuard, m_wakeTime, [this]() {return m_wakeTime <= system_clock::now(); });
+      // Read the epoch before the wake time.  A producer that lowers the wake time after
+      // this also bumps the epoch, so the wait returns straight away instead of sleeping
+      // past the new time.
+      uint32_t epoch = m_wakeSignal.Epoch();
+      TimePoint wakeTime = m_wakeTime.load();
+      TimePoint now = Clock::now();
+
+      if (wakeTime > now) {
+        if (!m_done) {
+          m_wakeSignal.WaitUntil(epoch, wakeTime, m_settings.m_wakeSpin);
+        }
+        continue;
       }
 
+      m_wakeLateness.Record(now - wakeTime);
       ProcessReadyTasks();
 
     }
@@ -31,157 +63,541 @@ namespace ndtech {
   }
 
   void Scheduler::ProcessReadyTasks() {
-    auto beginProcessingTime = system_clock::now();
+    NDTECH_TRACE_SCOPE("Scheduler::ProcessReadyTasks");
 
+    RunLane(m_criticalLane, CountersFor(TaskLane::Critical), m_settings.m_criticalLaneBudget, "Critical task");
+
+    size_t drainedTasks = DrainInbox();
+
+    auto beginProcessingTime = Clock::now();
+
+    // Pull everything that is due out of the queues first so the tasks run without the
+    // queue locks held and can schedule more work themselves
     {
       std::lock_guard<std::mutex> lockGuard(m_repeatingTasksMutex);
-
-      // For each repeating tasks where the next time is less than the current processing time
-      // run the task
-      std::for_each(
-        m_repeatingTasks.begin(),
-        std::find_if(
-          m_repeatingTasks.begin(),
-          m_repeatingTasks.end(),
-          // check if the next time for the task is now
-          [this, beginProcessingTime](std::tuple<std::function<void(void)>, microseconds, time_point<system_clock>, time_point<system_clock>> task) {
-            return std::get<2>(task) > beginProcessingTime;
-          }),
-        // Update the next execution time and run the task
-            [](std::tuple<std::function<void(void)>, microseconds, time_point<system_clock>, time_point<system_clock>>& task) {
-            std::get<2>(task) = (std::get<2>(task) + std::get<1>(task));
-            std::get<0>(task)();
-          });
-
-      // Erase repeating tasks where until is less than the current processing time
-      m_repeatingTasks.erase(
-        m_repeatingTasks.begin(),
-        std::find_if(
-          m_repeatingTasks.begin(),
-          m_repeatingTasks.end(),
-          [this, beginProcessingTime](std::tuple<std::function<void(void)>, microseconds, time_point<system_clock>, time_point<system_clock>> task) {
-            return std::get<3>(task) > beginProcessingTime;
-          })
-      );
-
-    }
-
-    std::lock_guard<std::mutex> lockGuard(m_tasksMutex);
-
-    std::for_each(
-      m_tasks.begin(),
-      std::find_if(
-        m_tasks.begin(),
-        m_tasks.end(),
-        // check if the scheduled time for the task is now or past
-        [this, beginProcessingTime](std::pair<std::function<void(void)>, time_point<system_clock>> task) {
-          bool returnValue = (task.second > beginProcessingTime);
-          return returnValue;
-        }),
-      // run the task
-          [](std::pair<std::function<void(void)>, time_point<system_clock>> task) {
-          task.first();
-        });
-
-    m_tasks.erase(
-      m_tasks.begin(),
-      std::find_if(
-        m_tasks.begin(),
-        m_tasks.end(),
-        // check if the scheduled time for the task is now or past
-        [this, beginProcessingTime](std::pair<std::function<void(void)>, time_point<system_clock>> task) {
-          return task.second > beginProcessingTime;
-        })
-    );
-
-    if (m_tasks.size() > 0) {
-      m_wakeTime = m_tasks[0].second;
+      PopReadyRepeatingTasks(beginProcessingTime, m_readyRepeatingTasks);
     }
-    else {
-      m_wakeTime = system_clock::now() + 300ms;
+
+    auto catchUpDeadline = beginProcessingTime + m_settings.m_catchUpBudget;
+    for (auto& entry : m_readyRepeatingTasks) {
+      NDTECH_TRACE_TASK("Repeating task", entry.m_time);
+      RunRepeatingTask(entry, beginProcessingTime, catchUpDeadline);
     }
 
-    if (m_repeatingTasks.size() > 0) {
-      if (std::get<2>(m_repeatingTasks[0]) < m_wakeTime) {
-        m_wakeTime = std::get<2>(m_repeatingTasks[0]);
+    {
+      std::lock_guard<std::mutex> lockGuard(m_repeatingTasksMutex);
+
+      // Requeue the tasks that have not reached until
+      for (auto& entry : m_readyRepeatingTasks) {
+        if (entry.m_time <= entry.m_payload.m_until) {
+          PushRepeatingTask(std::move(entry));
+        }
+        else {
+          m_repeatingTaskCount--;
+        }
       }
     }
+    m_readyRepeatingTasks.clear();
 
-  }
+    // m_tasks is only touched by the scheduler thread, producers go through the inbox
+    m_tasks.PopReady(beginProcessingTime, m_readyTasks);
 
-  void Scheduler::AddTask(std::pair<std::function<void(void)>, time_point<system_clock>> task) {
-    { // to scope the lock guard
-      std::lock_guard<std::mutex> guard(m_tasksMutex);
-      m_tasks.push_back(task);
+    LaneCounters& backgroundCounters = CountersFor(TaskLane::Background);
+    for (auto& entry : m_readyTasks) {
+      // Critical work added meanwhile goes ahead of the remaining background tasks
+      RunLane(m_criticalLane, CountersFor(TaskLane::Critical), m_settings.m_criticalLaneBudget, "Critical task");
 
-      if (task.second < m_wakeTime) {
-        m_wakeTime = task.second;
+      // In Fibers mode due tasks move on to the fibers, where blocking is cheap
+      if (m_fiberPool) {
+        m_fiberPool->Submit(std::move(entry.m_payload));
+        continue;
       }
 
-      std::sort(
-        m_tasks.begin(),
-        m_tasks.end(),
-        [](std::pair<std::function<void(void)>, time_point<system_clock>> l, std::pair<std::function<void(void)>, time_point<system_clock>> r) {
-          return l.second < r.second;
-        });
+      NDTECH_TRACE_TASK("Task", entry.m_time);
+      backgroundCounters.RecordTask(Clock::now() - entry.m_time);
+      entry.m_payload();
     }
+    m_readyTasks.clear();
 
-    if (m_wakeTime <= system_clock::now()) {
-      // signal the thread to wake
-      m_conditionVariable.notify_all();
+    TimePoint nextTime;
+    TimePoint wakeTime = Clock::now() + 300ms;
+
+    {
+      std::lock_guard<std::mutex> lockGuard(m_repeatingTasksMutex);
+      if (NextRepeatingTaskTime(nextTime) && nextTime < wakeTime) {
+        wakeTime = nextTime;
+      }
+    }
+
+    // Publish the wake time before the final drain.  A producer that pushed too late to be
+    // drained here lowers the wake time after this store and so is not lost.
+    size_t lateTasks = 0;
+    do {
+      if (m_tasks.NextTime(nextTime) && nextTime < wakeTime) {
+        wakeTime = nextTime;
+      }
+      if (!m_criticalLane.Empty()) {
+        wakeTime = Clock::now();
+      }
+      m_wakeTime.store(wakeTime);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      lateTasks = DrainInbox();
+      drainedTasks += lateTasks;
+    } while (lateTasks > 0);
+
+    m_wakeups.fetch_add(1, std::memory_order_relaxed);
+    m_drainedTasks.fetch_add(drainedTasks, std::memory_order_relaxed);
+    m_lastDrainedTasks.store(drainedTasks, std::memory_order_relaxed);
+    if (drainedTasks > m_maxDrainedTasks.load(std::memory_order_relaxed)) {
+      m_maxDrainedTasks.store(drainedTasks, std::memory_order_relaxed);
     }
+
+  }
+
+  TaskHandle Scheduler::AddTask(std::pair<Task, time_point<system_clock>> task) {
+    return AddTask(std::make_pair(std::move(task.first), ToSchedulerTime(task.second)));
+  }
+
+  TaskHandle Scheduler::AddTask(std::pair<Task, TimePoint> task) {
+    return AddTask(std::move(task), NoCoalescingTag);
   }
 
-  void Scheduler::AddTask(std::function<void(void)> taskFunction) {
+  TaskHandle Scheduler::AddTask(std::pair<Task, TimePoint> task, uint64_t coalescingTag) {
+    TaskHandle handle = Admit(task.first, coalescingTag);
+    if (handle.IsRejected()) {
+      return handle;
+    }
+
+    // Work that is already due skips the timed queue when there are workers to run it
+    if (task.second <= Clock::now() && SubmitToPool(task.first)) {
+      return handle;
+    }
+
+    m_inbox.Push(NewInboxTask(std::move(task.first), task.second));
 
-    std::pair<std::function<void(void)>, time_point<system_clock>> task{ taskFunction, system_clock::now() };
+    LowerWakeTime(task.second);
 
-    { // to scope the lock guard
-      std::lock_guard<std::mutex> guard(m_tasksMutex);
-      m_tasks.push_back(task);
+    return handle;
+  }
+
+  TaskHandle Scheduler::AddTask(Task taskFunction) {
+    return AddTask(std::move(taskFunction), NoCoalescingTag);
+  }
 
-      if (task.second < m_wakeTime) {
-        m_wakeTime = task.second;
+  TaskHandle Scheduler::AddTask(Task taskFunction, uint64_t coalescingTag) {
+    if (m_workerPool || m_fiberPool) {
+      TaskHandle handle = Admit(taskFunction, coalescingTag);
+      if (!handle.IsRejected()) {
+        SubmitToPool(taskFunction);
       }
+      return handle;
+    }
+
+    return AddTask(std::make_pair(std::move(taskFunction), Clock::now()), coalescingTag);
+  }
 
-      std::sort(
-        m_tasks.begin(),
-        m_tasks.end(),
-        [](std::pair<std::function<void(void)>, time_point<system_clock>> l, std::pair<std::function<void(void)>, time_point<system_clock>> r) {
-          return l.second < r.second;
-        });
+
+  TaskHandle Scheduler::AddTask(Task taskFunction, TaskLane lane) {
+    if (lane == TaskLane::Background) {
+      return AddTask(std::move(taskFunction));
     }
 
-    if (m_wakeTime <= system_clock::now()) {
-      // signal the thread to wake
-      m_conditionVariable.notify_all();
+    TaskHandle handle = Admit(taskFunction, NoCoalescingTag);
+    if (handle.IsRejected()) {
+      return handle;
     }
+
+    switch (lane) {
+    case TaskLane::Critical:
+      m_criticalLane.Push(NewInboxTask(std::move(taskFunction), Clock::now()));
+      LowerWakeTime(Clock::now());
+      break;
+
+    case TaskLane::PerFrame:
+      m_frameLane.Push(NewInboxTask(std::move(taskFunction), Clock::now()));
+      break;
+
+    default:
+      m_idleLane.Push(NewInboxTask(std::move(taskFunction), Clock::now()));
+      break;
+    }
+
+    return handle;
   }
 
+  void Scheduler::RunFrameTasks() {
+    RunFrameTasks(m_settings.m_frameLaneBudget);
+  }
+
+  void Scheduler::RunFrameTasks(microseconds budget) {
+    RunLane(m_frameLane, CountersFor(TaskLane::PerFrame), budget, "Frame task");
+  }
+
+  void Scheduler::RunIdleTasks(microseconds slack) {
+    RunLane(m_idleLane, CountersFor(TaskLane::Idle), slack, "Idle task");
+  }
 
   // until set a year in the future if not explicitly set
-  void Scheduler::AddRepeatingTask(std::function<void(void)> task, microseconds interval, time_point<system_clock> until = system_clock::now() + 8760h) {
+  bool Scheduler::AddRepeatingTask(Task task, microseconds interval, time_point<system_clock> until = system_clock::now() + 8760h, MissedDeadlinePolicy policy) {
 
     std::lock_guard<std::mutex> repeatingTasksGuard(m_repeatingTasksMutex);
-    time_point<system_clock> nextExecution = system_clock::now() + interval;
-    m_repeatingTasks.push_back(std::make_tuple(task, interval, nextExecution, until));
 
-    if (nextExecution < m_wakeTime) {
-      m_wakeTime = nextExecution;
+    if (m_settings.m_maxRepeatingTasks > 0 && m_repeatingTaskCount >= m_settings.m_maxRepeatingTasks) {
+      m_rejectedTasks.fetch_add(1, std::memory_order_relaxed);
+      return false;
     }
+    m_repeatingTaskCount++;
 
-    std::sort(
-      m_repeatingTasks.begin(),
-      m_repeatingTasks.end(),
-      [](std::tuple<std::function<void(void)>, microseconds, time_point<system_clock>, time_point<system_clock>> l, std::tuple<std::function<void(void)>, microseconds, time_point<system_clock>, time_point<system_clock>> r) {
-        return std::get<2>(l) < std::get<2>(r);
-      });
+    TimePoint nextExecution = Clock::now() + interval;
+    PushRepeatingTask(RepeatingTaskEntry{ RepeatingTask{ std::move(task), interval, ToSchedulerTime(until), policy }, nextExecution, m_repeatingTaskSequence++ });
 
+    LowerWakeTime(nextExecution);
+
+    return true;
   }
 
   void Scheduler::Join() {
     this->m_done = true;
+    m_wakeSignal.Notify();
+    m_capacitySignal.Notify();
     m_thread.join();
+
+    // Release anything still waiting in the inbox, the timed queue and the lanes.  Tasks
+    // with handles are dropped, which finishes their handles.
+    DrainInbox();
+    m_tasks.PopReady(TimePoint::max(), m_readyTasks);
+    m_readyTasks.clear();
+    for (MpscQueue<InboxTask>* lane : { &m_criticalLane, &m_frameLane, &m_idleLane }) {
+      while (InboxTask* inboxTask = lane->Pop()) {
+        DeleteInboxTask(inboxTask);
+      }
+    }
+
+    if (m_workerPool) {
+      m_workerPool->Join();
+    }
+    if (m_fiberPool) {
+      m_fiberPool->Join();
+    }
+  }
+
+  size_t Scheduler::WorkerCount() const {
+    if (m_workerPool) {
+      return m_workerPool->WorkerCount();
+    }
+    if (m_fiberPool) {
+      return m_fiberPool->ThreadCount();
+    }
+    return 0;
+  }
+
+  SchedulerStats Scheduler::GetStats() const {
+    SchedulerStats stats;
+    stats.m_wakeups = m_wakeups.load(std::memory_order_relaxed);
+    stats.m_drainedTasks = m_drainedTasks.load(std::memory_order_relaxed);
+    stats.m_lastDrainedTasks = m_lastDrainedTasks.load(std::memory_order_relaxed);
+    stats.m_maxDrainedTasks = m_maxDrainedTasks.load(std::memory_order_relaxed);
+    stats.m_skippedRuns = m_skippedRuns.load(std::memory_order_relaxed);
+    stats.m_coalescedRuns = m_coalescedRuns.load(std::memory_order_relaxed);
+    stats.m_deferredCatchUpRuns = m_deferredCatchUpRuns.load(std::memory_order_relaxed);
+    stats.m_rejectedTasks = m_rejectedTasks.load(std::memory_order_relaxed);
+    stats.m_coalescedTasks = m_coalescedTasks.load(std::memory_order_relaxed);
+    stats.m_blockedSubmissions = m_blockedSubmissions.load(std::memory_order_relaxed);
+    stats.m_wakeLateness = m_wakeLateness.Percentiles();
+    for (size_t lane = 0; lane < m_laneCounters.size(); lane++) {
+      stats.m_lanes[lane] = m_laneCounters[lane].Snapshot();
+    }
+    return stats;
+  }
+
+  Scheduler::TimePoint Scheduler::ToSchedulerTime(time_point<system_clock> time) {
+    return Clock::now() + duration_cast<Clock::duration>(time - system_clock::now());
+  }
+
+  // Runs a due repeating task according to its policy and advances entry.m_time to its next
+  // deadline.  Deadlines stay on the grid of the first one, so a late run never adds drift.
+  void Scheduler::RunRepeatingTask(RepeatingTaskEntry& entry, TimePoint now, TimePoint catchUpDeadline) {
+    RepeatingTask& task = entry.m_payload;
+
+    // Whole intervals that have passed since this deadline, so also the number of later
+    // deadlines that are already due
+    uint64_t missedRuns = static_cast<uint64_t>((now - entry.m_time) / task.m_interval);
+
+    switch (task.m_policy) {
+    case MissedDeadlinePolicy::Skip:
+      if (missedRuns == 0) {
+        task.m_function();
+      }
+      else {
+        m_skippedRuns.fetch_add(missedRuns + 1, std::memory_order_relaxed);
+      }
+      entry.m_time += task.m_interval * (missedRuns + 1);
+      break;
+
+    case MissedDeadlinePolicy::Coalesce:
+      task.m_function();
+      m_coalescedRuns.fetch_add(missedRuns, std::memory_order_relaxed);
+      entry.m_time += task.m_interval * (missedRuns + 1);
+      break;
+
+    case MissedDeadlinePolicy::CatchUp:
+      if (missedRuns > m_settings.m_maxCatchUpRuns) {
+        uint64_t droppedRuns = missedRuns - m_settings.m_maxCatchUpRuns;
+        m_coalescedRuns.fetch_add(droppedRuns, std::memory_order_relaxed);
+        entry.m_time += task.m_interval * droppedRuns;
+      }
+
+      task.m_function();
+      entry.m_time += task.m_interval;
+
+      while (entry.m_time <= now && entry.m_time <= task.m_until) {
+        if (Clock::now() >= catchUpDeadline) {
+          // Out of budget, the remaining runs stay due and go first on the next pass
+          m_deferredCatchUpRuns.fetch_add(1, std::memory_order_relaxed);
+          break;
+        }
+        task.m_function();
+        entry.m_time += task.m_interval;
+      }
+      break;
+    }
+  }
+
+  // Applies m_maxQueuedTasks and the QueueFullPolicy, then gives the task its handle.  A
+  // rejected task is left in taskFunction and is destroyed by the caller.
+  TaskHandle Scheduler::Admit(Task& taskFunction, uint64_t coalescingTag) {
+    bool blocked = false;
+
+    while (QueueFull()) {
+      if (m_settings.m_queueFullPolicy == QueueFullPolicy::Block && std::this_thread::get_id() == m_thread.get_id()) {
+        break;
+      }
+
+      // The pool threads are what empties the queue, so one waiting here could be waiting
+      // on itself.  Under Block they are rejected instead.
+      if (m_settings.m_queueFullPolicy == QueueFullPolicy::Block && !OnPoolThread()) {
+        // Take the epoch before checking again, so a task that starts in between is seen
+        uint32_t epoch = m_capacitySignal.Epoch();
+        if (!QueueFull()) {
+          break;
+        }
+        if (m_done) {
+          m_rejectedTasks.fetch_add(1, std::memory_order_relaxed);
+          return TaskHandle::Rejected();
+        }
+        if (!blocked) {
+          blocked = true;
+          m_blockedSubmissions.fetch_add(1, std::memory_order_relaxed);
+        }
+        m_capacitySignal.WaitUntil(epoch, Clock::now() + 100ms, microseconds::zero());
+        continue;
+      }
+
+      if (m_settings.m_queueFullPolicy == QueueFullPolicy::DropOldest && CoalesceOldest(coalescingTag)) {
+        break;
+      }
+
+      m_rejectedTasks.fetch_add(1, std::memory_order_relaxed);
+      return TaskHandle::Rejected();
+    }
+
+    TaskHandle handle = MakeHandle(taskFunction);
+
+    if (coalescingTag != NoCoalescingTag && handle && m_settings.m_queueFullPolicy == QueueFullPolicy::DropOldest) {
+      std::lock_guard<std::mutex> guard(m_taggedTasksMutex);
+      TaggedTasks& taggedTasks = m_taggedTasks[coalescingTag];
+      while (!taggedTasks.Empty() && taggedTasks.Front().IsDone()) {
+        taggedTasks.PopFront();
+      }
+      taggedTasks.PushBack(handle);
+    }
+
+    return handle;
+  }
+
+  bool Scheduler::QueueFull() const {
+    return m_settings.m_maxQueuedTasks > 0 && m_taskSlots.QueuedTasks() >= m_settings.m_maxQueuedTasks;
+  }
+
+  bool Scheduler::OnPoolThread() const {
+    return (m_workerPool && m_workerPool->OnWorkerThread()) || (m_fiberPool && m_fiberPool->OnPoolThread());
+  }
+
+  // Cancels the oldest task with coalescingTag that has not started yet
+  bool Scheduler::CoalesceOldest(uint64_t coalescingTag) {
+    if (coalescingTag == NoCoalescingTag) {
+      return false;
+    }
+
+    std::lock_guard<std::mutex> guard(m_taggedTasksMutex);
+    auto taggedTasks = m_taggedTasks.find(coalescingTag);
+    if (taggedTasks == m_taggedTasks.end()) {
+      return false;
+    }
+
+    while (!taggedTasks->second.Empty()) {
+      TaskHandle oldest = taggedTasks->second.Front();
+      taggedTasks->second.PopFront();
+      if (oldest.Cancel()) {
+        m_coalescedTasks.fetch_add(1, std::memory_order_relaxed);
+        return true;
+      }
+    }
+
+    m_taggedTasks.erase(taggedTasks);
+    return false;
+  }
+
+  // Moves the task into a slot and leaves a SlotTask in its place, so whatever queue it goes
+  // to runs the task through its slot.  If the table is full the task is queued as it is.
+  TaskHandle Scheduler::MakeHandle(Task& taskFunction) {
+    uint32_t index;
+    uint32_t generation;
+    if (!m_taskSlots.Acquire(taskFunction, index, generation)) {
+      return TaskHandle{};
+    }
+
+    taskFunction = SlotTask{ &m_taskSlots, index, generation };
+    return TaskHandle{ &m_taskSlots, index, generation };
+  }
+
+  // Inbox nodes come from a slab pool, so a warm scheduler adds tasks without allocating
+  Scheduler::InboxTask* Scheduler::NewInboxTask(Task function, TimePoint time) {
+    void* storage = m_inboxTaskPool.Allocate();
+    InboxTask* inboxTask = storage != nullptr ? new (storage) InboxTask() : new InboxTask();
+    inboxTask->m_function = std::move(function);
+    inboxTask->m_time = time;
+    inboxTask->m_pooled = storage != nullptr;
+    return inboxTask;
+  }
+
+  void Scheduler::DeleteInboxTask(InboxTask* inboxTask) {
+    if (inboxTask->m_pooled) {
+      m_inboxTaskPool.Delete(inboxTask);
+    }
+    else {
+      delete inboxTask;
+    }
+  }
+
+  // Scheduler thread only
+  size_t Scheduler::DrainInbox() {
+    size_t drainedTasks = 0;
+
+    while (true) {
+      InboxTask* inboxTask = m_inbox.Pop();
+      if (inboxTask == nullptr) {
+        // A producer may be between pushing and linking its task, and may already have
+        // checked the wake time; wait the few instructions for it rather than sleep past it
+        if (m_inbox.Empty()) {
+          break;
+        }
+        std::this_thread::yield();
+        continue;
+      }
+
+      m_tasks.Push(TaskEntry{ std::move(inboxTask->m_function), inboxTask->m_time, m_taskSequence++ });
+      DeleteInboxTask(inboxTask);
+      drainedTasks++;
+    }
+
+    return drainedTasks;
+  }
+
+  // Runs tasks from one lane until it is empty or the budget is spent.  A lane has a single
+  // consumer: the scheduler thread for Critical and the App::Loop thread for the others.
+  size_t Scheduler::RunLane(MpscQueue<InboxTask>& lane, LaneCounters& counters, microseconds budget, const char* traceName) {
+    if (budget <= microseconds::zero()) {
+      return 0;
+    }
+
+    // Checked before reading the clock, this is called between every background task
+    InboxTask* inboxTask = lane.Pop();
+    if (inboxTask == nullptr) {
+      return 0;
+    }
+
+    TimePoint start = Clock::now();
+    TimePoint now = start;
+    size_t tasksRun = 0;
+
+    while (inboxTask != nullptr) {
+      {
+        NDTECH_TRACE_TASK(traceName, inboxTask->m_time);
+        counters.RecordTask(now - inboxTask->m_time);
+        inboxTask->m_function();
+      }
+      DeleteInboxTask(inboxTask);
+      tasksRun++;
+
+      now = Clock::now();
+      if (now - start >= budget) {
+        break;
+      }
+      inboxTask = lane.Pop();
+    }
+
+    if (now - start > budget) {
+      counters.RecordOverrun();
+    }
+
+    return tasksRun;
+  }
+
+  LaneCounters& Scheduler::CountersFor(TaskLane lane) {
+    return m_laneCounters[static_cast<size_t>(lane)];
+  }
+
+  // Never blocks: the wake time is lowered with a compare and swap, and the scheduler
+  // thread is only signalled when the new time is earlier than the one it sleeps toward
+  void Scheduler::LowerWakeTime(TimePoint time) {
+    // Orders the caller's push before this load; pairs with the fence in ProcessReadyTasks
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    TimePoint wakeTime = m_wakeTime.load();
+    while (time < wakeTime) {
+      if (m_wakeTime.compare_exchange_weak(wakeTime, time)) {
+        m_wakeSignal.Notify();
+        return;
+      }
+    }
+  }
+
+  void Scheduler::PushRepeatingTask(RepeatingTaskEntry entry) {
+    if (m_repeatingTasksWheel) {
+      m_repeatingTasksWheel->Push(std::move(entry));
+    }
+    else {
+      m_repeatingTasks.Push(std::move(entry));
+    }
+  }
+
+  void Scheduler::PopReadyRepeatingTasks(TimePoint now, std::vector<RepeatingTaskEntry>& ready) {
+    if (m_repeatingTasksWheel) {
+      m_repeatingTasksWheel->PopReady(now, ready);
+    }
+    else {
+      m_repeatingTasks.PopReady(now, ready);
+    }
+  }
+
+  bool Scheduler::NextRepeatingTaskTime(TimePoint& nextTime) {
+    if (m_repeatingTasksWheel) {
+      return m_repeatingTasksWheel->NextTime(nextTime);
+    }
+    return m_repeatingTasks.NextTime(nextTime);
+  }
+
+  // Hands the task to the worker or fiber pool, if there is one
+  bool Scheduler::SubmitToPool(Task& taskFunction) {
+    if (m_workerPool) {
+      m_workerPool->Submit(std::move(taskFunction));
+      return true;
+    }
+    if (m_fiberPool) {
+      m_fiberPool->Submit(std::move(taskFunction));
+      return true;
+    }
+    return false;
   }
 
 }
\ No newline at end of file
@@ -1,11 +1,23 @@
 #pragma once
 
 #include <vector>
-#include <functional>
 #include <chrono>
-#include <condition_variable>
 #include <thread>
 #include <mutex>
+#include <memory>
+#include <atomic>
+#include <array>
+#include <unordered_map>
+
+#include "MpscQueue.h"
+#include "SchedulerCounters.h"
+#include "SlabPool.h"
+#include "Task.h"
+#include "TaskHandle.h"
+#include "TaskQueue.h"
+#include "WakeSignal.h"
+#include "FiberPool.h"
+#include "WorkerPool.h"
 
 
 using namespace std::chrono;
@@ -13,35 +25,275 @@ using namespace std::chrono_literals;
 
 namespace ndtech {
 
+  enum class SchedulerMode {
+    // Every task runs on the scheduler thread
+    SingleThread,
+    // Immediate tasks run on a pool of work-stealing workers, timed tasks still fire on the
+    // scheduler thread
+    WorkStealing,
+    // Immediate tasks, and timed tasks once due, run as fibers on m_workerCount threads
+    // under boost's work_stealing algorithm, so a task blocked on a fiber primitive such
+    // as NamedItemStore::GetItem gives up its thread.  Repeating tasks stay on the
+    // scheduler thread.  Only one Scheduler per process can use this mode.
+    Fibers
+  };
+
+  // What a repeating task does when the scheduler reaches it more than one interval late
+  enum class MissedDeadlinePolicy {
+    // Drop the late run and resume at the next interval boundary after now
+    Skip,
+    // Run once for all of the missed deadlines, then resume at the next interval boundary
+    Coalesce,
+    // Run once per missed deadline, limited by the settings' catch-up budget
+    CatchUp
+  };
+
+  // What AddTask does once m_maxQueuedTasks tasks are already waiting
+  enum class QueueFullPolicy {
+    // Wait until a queued task starts or is cancelled.  Never waits on the threads that
+    // run the tasks, which would be waiting on their own work: a task on the scheduler
+    // thread that adds more is let through, one on a worker or fiber pool thread is
+    // rejected as under Reject.
+    Block,
+    // Return at once with a handle whose IsRejected() is true
+    Reject,
+    // Cancel the oldest waiting task with the same coalescing tag and take its place.
+    // Untagged tasks, and tags with nothing waiting, are rejected.
+    DropOldest
+  };
+
+  // Priority lanes for immediate work
+  enum class TaskLane {
+    // Runs on the scheduler thread ahead of any other queued work
+    Critical,
+    // Drained by App::Loop once per frame, before rendering, within m_frameLaneBudget
+    PerFrame,
+    // The ordinary AddTask path, on the scheduler thread or the worker pool
+    Background,
+    // Drained by App::Loop only while StepTimer reports slack left in the frame
+    Idle,
+    Count
+  };
+
+  struct SchedulerSettings {
+    SchedulerMode   m_mode = SchedulerMode::SingleThread;
+    size_t          m_workerCount = std::thread::hardware_concurrency();
+
+    // Repeating tasks go to a hierarchical timer wheel instead of the min-heap
+    bool            m_useTimerWheel = false;
+    microseconds    m_timerWheelResolution = 1000us;
+
+    // Time a single pass may spend on extra catch-up runs before the rest are deferred
+    microseconds    m_catchUpBudget = 2000us;
+    // Missed runs a CatchUp task may owe; anything older is coalesced away
+    size_t          m_maxCatchUpRuns = 8;
+
+    // Time RunFrameTasks may spend per frame
+    microseconds    m_frameLaneBudget = 2000us;
+    // Time a pass of the scheduler thread may spend on critical tasks
+    microseconds    m_criticalLaneBudget = 1000us;
+
+    // How long the scheduler thread spins for new work before it parks, and how far ahead
+    // of a deadline it stops parking and spins instead
+    microseconds    m_wakeSpin = 100us;
+
+    // Tasks added with AddTask that may be waiting to start at once, 0 for no limit.
+    // Running tasks do not count.  Concurrent producers may overshoot it by one task each.
+    size_t          m_maxQueuedTasks = 0;
+    QueueFullPolicy m_queueFullPolicy = QueueFullPolicy::Reject;
+    // Repeating tasks that may be registered at once, 0 for no limit.  Repeating tasks
+    // have no end to wait for or older run to replace, so past this they are rejected.
+    size_t          m_maxRepeatingTasks = 0;
+  };
+
+  struct SchedulerStats {
+    // Number of times the scheduler thread woke up and processed its queues
+    uint64_t    m_wakeups = 0;
+    // Tasks moved from the submission inbox into the timed queue
+    uint64_t    m_drainedTasks = 0;
+    size_t      m_lastDrainedTasks = 0;
+    size_t      m_maxDrainedTasks = 0;
+    // Repeating task runs dropped, merged or postponed by their MissedDeadlinePolicy
+    uint64_t    m_skippedRuns = 0;
+    uint64_t    m_coalescedRuns = 0;
+    uint64_t    m_deferredCatchUpRuns = 0;
+    // Tasks turned away or replaced by the QueueFullPolicy, and submissions that waited
+    uint64_t    m_rejectedTasks = 0;
+    uint64_t    m_coalescedTasks = 0;
+    uint64_t    m_blockedSubmissions = 0;
+    // How long after its wake time the scheduler thread started processing
+    LatencyPercentiles  m_wakeLateness;
+    // Indexed by TaskLane
+    std::array<LaneStats, static_cast<size_t>(TaskLane::Count)>   m_lanes;
+  };
+
+  // All deadlines are kept on steady_clock so wall-clock adjustments cannot make tasks burst
+  // or stall.  system_clock times passed in are converted when the task is added.
   struct Scheduler {
 
+    using Clock = steady_clock;
+    using TimePoint = time_point<Clock>;
+
+    // Tag for tasks that nothing may coalesce with
+    static constexpr uint64_t NoCoalescingTag = 0;
+
     Scheduler();
 
+    Scheduler(SchedulerSettings settings);
+
     Scheduler(std::thread thread);
 
     void Run();
 
     void ProcessReadyTasks();
 
-    void AddTask(std::pair<std::function<void(void)>, time_point<system_clock>> task);
+    // The returned handle can cancel the task before it starts, poll for completion, or be
+    // co_awaited where coroutines are available.  Callers that do not need it can drop it.
+    TaskHandle AddTask(std::pair<Task, time_point<system_clock>> task);
 
-    void AddTask(std::function<void(void)> taskFunction);
+    TaskHandle AddTask(std::pair<Task, TimePoint> task);
 
-    void AddRepeatingTask(std::function<void(void)> task, microseconds interval, time_point<system_clock> until);
+    // With QueueFullPolicy::DropOldest a full queue makes room by cancelling the oldest
+    // waiting task that has the same coalescingTag
+    TaskHandle AddTask(std::pair<Task, TimePoint> task, uint64_t coalescingTag);
+
+    TaskHandle AddTask(Task taskFunction);
+
+    TaskHandle AddTask(Task taskFunction, uint64_t coalescingTag);
+
+    TaskHandle AddTask(Task taskFunction, TaskLane lane);
+
+    // Returns false if m_maxRepeatingTasks are already registered
+    bool AddRepeatingTask(Task task, microseconds interval, time_point<system_clock> until, MissedDeadlinePolicy policy = MissedDeadlinePolicy::Coalesce);
+
+    // Runs PerFrame lane tasks on the calling thread until the lane is empty or the budget
+    // is spent.  Called by App::Loop between updating and rendering.
+    void RunFrameTasks();
+
+    void RunFrameTasks(microseconds budget);
+
+    // Runs Idle lane tasks on the calling thread for at most slack
+    void RunIdleTasks(microseconds slack);
 
     void Join();
 
+    SchedulerStats GetStats() const;
+
+    // Threads besides the scheduler thread that run tasks added with AddTask, 0 in
+    // SingleThread mode
+    size_t WorkerCount() const;
+
+    static TimePoint ToSchedulerTime(time_point<system_clock> time);
+
   private:
+    struct RepeatingTask {
+      Task                        m_function;
+      microseconds                m_interval;
+      TimePoint                   m_until;
+      MissedDeadlinePolicy        m_policy;
+    };
+
+    using TaskEntry = TimedEntry<Task, TimePoint>;
+
+    struct InboxTask : MpscNode {
+      Task                        m_function;
+      TimePoint                   m_time;
+      bool                        m_pooled;
+    };
+    using RepeatingTaskEntry = TimedEntry<RepeatingTask, TimePoint>;
+
+    // A tag's waiting tasks, oldest first, in a ring that only grows, so a tag that is in
+    // steady use adds tasks without allocating
+    struct TaggedTasks {
+      std::vector<TaskHandle>     m_handles;
+      size_t                      m_head = 0;
+      size_t                      m_count = 0;
+
+      bool Empty() const { return m_count == 0; }
+
+      const TaskHandle& Front() const { return m_handles[m_head]; }
+
+      void PopFront() {
+        m_head = (m_head + 1) & (m_handles.size() - 1);
+        m_count--;
+      }
+
+      void PushBack(TaskHandle handle) {
+        if (m_count == m_handles.size()) {
+          Grow();
+        }
+        m_handles[(m_head + m_count) & (m_handles.size() - 1)] = handle;
+        m_count++;
+      }
+
+    private:
+      void Grow() {
+        std::vector<TaskHandle> handles(m_handles.empty() ? 16 : m_handles.size() * 2);
+        for (size_t index = 0; index < m_count; index++) {
+          handles[index] = m_handles[(m_head + index) & (m_handles.size() - 1)];
+        }
+        m_handles.swap(handles);
+        m_head = 0;
+      }
+    };
+
+    TaskHandle Admit(Task& taskFunction, uint64_t coalescingTag);
+    bool QueueFull() const;
+    bool OnPoolThread() const;
+    bool CoalesceOldest(uint64_t coalescingTag);
+    TaskHandle MakeHandle(Task& taskFunction);
+    InboxTask* NewInboxTask(Task function, TimePoint time);
+    void DeleteInboxTask(InboxTask* inboxTask);
+    size_t DrainInbox();
+    size_t RunLane(MpscQueue<InboxTask>& lane, LaneCounters& counters, microseconds budget, const char* traceName);
+    LaneCounters& CountersFor(TaskLane lane);
+    void LowerWakeTime(TimePoint time);
+    void RunRepeatingTask(RepeatingTaskEntry& entry, TimePoint now, TimePoint catchUpDeadline);
+    void PushRepeatingTask(RepeatingTaskEntry entry);
+    void PopReadyRepeatingTasks(TimePoint now, std::vector<RepeatingTaskEntry>& ready);
+    bool NextRepeatingTaskTime(TimePoint& nextTime);
+    bool SubmitToPool(Task& taskFunction);
+
+    SchedulerSettings                                                                                                     m_settings;
     size_t                                                                                                                m_cache_line_size;
     std::thread                                                                                                           m_thread;
-    std::mutex                                                                                                            m_tasksMutex;
-    std::vector<std::pair<std::function<void(void)>, time_point<system_clock>>>                                           m_tasks;
+    WakeSignal                                                                                                            m_capacitySignal;
+    // Declared ahead of every queue, queued SlotTasks release their slots as they are destroyed
+    // and notify m_capacitySignal
+    TaskSlotTable                                                                                                         m_taskSlots;
+    std::unique_ptr<WorkerPool>                                                                                           m_workerPool;
+    std::unique_ptr<FiberPool>                                                                                            m_fiberPool;
+    SlabPool<sizeof(InboxTask)>                                                                                           m_inboxTaskPool;
+    MpscQueue<InboxTask>                                                                                                  m_inbox;
+    MpscQueue<InboxTask>                                                                                                  m_criticalLane;
+    MpscQueue<InboxTask>                                                                                                  m_frameLane;
+    MpscQueue<InboxTask>                                                                                                  m_idleLane;
+    std::array<LaneCounters, static_cast<size_t>(TaskLane::Count)>                                                        m_laneCounters;
+    TaskHeap<TaskEntry>                                                                                                   m_tasks;
+    uint64_t                                                                                                              m_taskSequence = 0;
+    std::vector<TaskEntry>                                                                                                m_readyTasks;
     std::mutex                                                                                                            m_repeatingTasksMutex;
-    std::vector<std::tuple<std::function<void(void)>, microseconds, time_point<system_clock>, time_point<system_clock>>>   m_repeatingTasks;
-    time_point<system_clock>                                                                                              m_wakeTime = system_clock::now() + 100ms;
-    std::mutex                                                                                                            m_waitMutex;
-    std::condition_variable                                                                                               m_conditionVariable;
-    bool                                                                                                                  m_done = false;
+    TaskHeap<RepeatingTaskEntry>                                                                                          m_repeatingTasks;
+    std::unique_ptr<TimerWheel<RepeatingTaskEntry>>                                                                       m_repeatingTasksWheel;
+    uint64_t                                                                                                              m_repeatingTaskSequence = 0;
+    size_t                                                                                                                m_repeatingTaskCount = 0;
+    std::vector<RepeatingTaskEntry>                                                                                       m_readyRepeatingTasks;
+    std::atomic<TimePoint>                                                                                                m_wakeTime{ Clock::now() + 100ms };
+    WakeSignal                                                                                                            m_wakeSignal;
+    LatencyHistogram                                                                                        m_wakeLateness;
+    std::atomic<bool>                                                                                                     m_done{ false };
+    std::atomic<uint64_t>                                                                                                 m_wakeups{ 0 };
+    std::atomic<uint64_t>                                                                                                 m_drainedTasks{ 0 };
+    std::atomic<size_t>                                                                                                   m_lastDrainedTasks{ 0 };
+    std::atomic<size_t>                                                                                                   m_maxDrainedTasks{ 0 };
+    std::atomic<uint64_t>                                                                                                 m_skippedRuns{ 0 };
+    std::atomic<uint64_t>                                                                                                 m_coalescedRuns{ 0 };
+    std::atomic<uint64_t>                                                                                                 m_deferredCatchUpRuns{ 0 };
+    std::mutex                                                                                                            m_taggedTasksMutex;
+    std::unordered_map<uint64_t, TaggedTasks>                                                                             m_taggedTasks;
+    std::atomic<uint64_t>                                                                                                 m_rejectedTasks{ 0 };
+    std::atomic<uint64_t>                                                                                                 m_coalescedTasks{ 0 };
+    std::atomic<uint64_t>                                                                                                 m_blockedSubmissions{ 0 };
   };
 
 }
\ No newline at end of file
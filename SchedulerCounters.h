@@ -0,0 +1,143 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace ndtech {
+
+  // Snapshot of one lane's counters
+  struct LaneStats {
+    uint64_t    m_tasksRun = 0;
+    // Time from when a task became runnable until it started
+    uint64_t    m_totalLatencyMicroseconds = 0;
+    uint64_t    m_maxLatencyMicroseconds = 0;
+    // Times a drain of the lane ran past its budget
+    uint64_t    m_budgetOverruns = 0;
+
+    double AverageLatencyMicroseconds() const {
+      return m_tasksRun > 0 ? static_cast<double>(m_totalLatencyMicroseconds) / m_tasksRun : 0.0;
+    }
+  };
+
+  // Live counters behind a LaneStats, safe to update from any thread
+  struct LaneCounters {
+    std::atomic<uint64_t>   m_tasksRun{ 0 };
+    std::atomic<uint64_t>   m_totalLatencyMicroseconds{ 0 };
+    std::atomic<uint64_t>   m_maxLatencyMicroseconds{ 0 };
+    std::atomic<uint64_t>   m_budgetOverruns{ 0 };
+
+    template <typename DurationType>
+    void RecordTask(DurationType latency) {
+      int64_t count = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+      uint64_t latencyMicroseconds = count > 0 ? static_cast<uint64_t>(count) : 0;
+
+      m_tasksRun.fetch_add(1, std::memory_order_relaxed);
+      m_totalLatencyMicroseconds.fetch_add(latencyMicroseconds, std::memory_order_relaxed);
+
+      uint64_t maxLatency = m_maxLatencyMicroseconds.load(std::memory_order_relaxed);
+      while (latencyMicroseconds > maxLatency
+        && !m_maxLatencyMicroseconds.compare_exchange_weak(maxLatency, latencyMicroseconds, std::memory_order_relaxed)) {
+      }
+    }
+
+    void RecordOverrun() {
+      m_budgetOverruns.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    LaneStats Snapshot() const {
+      LaneStats stats;
+      stats.m_tasksRun = m_tasksRun.load(std::memory_order_relaxed);
+      stats.m_totalLatencyMicroseconds = m_totalLatencyMicroseconds.load(std::memory_order_relaxed);
+      stats.m_maxLatencyMicroseconds = m_maxLatencyMicroseconds.load(std::memory_order_relaxed);
+      stats.m_budgetOverruns = m_budgetOverruns.load(std::memory_order_relaxed);
+      return stats;
+    }
+  };
+
+  // Percentiles read from a LatencyHistogram, in nanoseconds
+  struct LatencyPercentiles {
+    uint64_t    m_samples = 0;
+    uint64_t    m_p50Nanoseconds = 0;
+    uint64_t    m_p99Nanoseconds = 0;
+    uint64_t    m_p999Nanoseconds = 0;
+  };
+
+  // Log-linear histogram of nanosecond latencies: 16 buckets per power of two, so a
+  // percentile read back is at most about 6% above the true value.  Recording is one
+  // relaxed increment, safe from any thread.
+  struct LatencyHistogram {
+
+    static constexpr size_t SubBuckets = 16;
+    static constexpr size_t Groups = 48;
+
+    template <typename DurationType>
+    void Record(DurationType latency) {
+      int64_t count = std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count();
+      m_buckets[BucketFor(count > 0 ? static_cast<uint64_t>(count) : 0)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    LatencyPercentiles Percentiles() const {
+      uint64_t counts[Groups * SubBuckets];
+      LatencyPercentiles percentiles;
+
+      for (size_t bucket = 0; bucket < Groups * SubBuckets; bucket++) {
+        counts[bucket] = m_buckets[bucket].load(std::memory_order_relaxed);
+        percentiles.m_samples += counts[bucket];
+      }
+
+      percentiles.m_p50Nanoseconds = Percentile(counts, percentiles.m_samples, 0.5);
+      percentiles.m_p99Nanoseconds = Percentile(counts, percentiles.m_samples, 0.99);
+      percentiles.m_p999Nanoseconds = Percentile(counts, percentiles.m_samples, 0.999);
+      return percentiles;
+    }
+
+  private:
+    static size_t BucketFor(uint64_t value) {
+      if (value < SubBuckets) {
+        return static_cast<size_t>(value);
+      }
+
+      size_t highestBit = 4;
+      while ((value >> (highestBit + 1)) != 0) {
+        highestBit++;
+      }
+
+      size_t group = highestBit - 3;
+      if (group >= Groups) {
+        return Groups * SubBuckets - 1;
+      }
+      return group * SubBuckets + static_cast<size_t>((value >> (highestBit - 4)) & (SubBuckets - 1));
+    }
+
+    // Largest value that lands in bucket
+    static uint64_t BucketLimit(size_t bucket) {
+      size_t group = bucket / SubBuckets;
+      uint64_t subBucket = bucket % SubBuckets;
+      if (group == 0) {
+        return subBucket;
+      }
+      return ((SubBuckets + subBucket + 1) << (group - 1)) - 1;
+    }
+
+    static uint64_t Percentile(const uint64_t* counts, uint64_t samples, double fraction) {
+      if (samples == 0) {
+        return 0;
+      }
+
+      uint64_t rank = static_cast<uint64_t>(fraction * (samples - 1)) + 1;
+      uint64_t seen = 0;
+      for (size_t bucket = 0; bucket < Groups * SubBuckets; bucket++) {
+        seen += counts[bucket];
+        if (seen >= rank) {
+          return BucketLimit(bucket);
+        }
+      }
+      return BucketLimit(Groups * SubBuckets - 1);
+    }
+
+    std::atomic<uint64_t>   m_buckets[Groups * SubBuckets] = {};
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,176 @@
+#include "pch.h"
+#include "SchedulerTrace.h"
+
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ndtech {
+
+  namespace {
+
+    struct TraceRing {
+      std::array<TraceEvent, NDTECH_TRACE_RING_SIZE>  m_events;
+      // Total events ever written; the owning thread is the only writer
+      std::atomic<uint64_t>                           m_head{ 0 };
+      // Set by the owning thread while it writes an event, so a dump can wait for it
+      std::atomic<bool>                               m_writing{ false };
+      uint32_t                                        m_threadId = 0;
+    };
+
+    struct TraceRegistry {
+      std::mutex                                      m_mutex;
+      std::vector<std::unique_ptr<TraceRing>>         m_rings;
+      Tracer::Clock::time_point                       m_origin = Tracer::Clock::now();
+    };
+
+    TraceRegistry& GetTraceRegistry() {
+      static TraceRegistry registry;
+      return registry;
+    }
+
+    // Rings stay registered after their thread exits so its events can still be dumped
+    TraceRing& GetThreadRing() {
+      thread_local TraceRing* t_ring = nullptr;
+
+      if (t_ring == nullptr) {
+        TraceRegistry& registry = GetTraceRegistry();
+        std::lock_guard<std::mutex> guard(registry.m_mutex);
+        registry.m_rings.push_back(std::make_unique<TraceRing>());
+        t_ring = registry.m_rings.back().get();
+        t_ring->m_threadId = static_cast<uint32_t>(registry.m_rings.size());
+      }
+
+      return *t_ring;
+    }
+
+    // Call with the registry mutex held and tracing disabled.  A writer marks its ring
+    // before it checks whether tracing is enabled, and the dump disables tracing before it
+    // looks at the marks, so once every mark is clear no thread is writing or will write.
+    void WaitForWriters(TraceRegistry& registry) {
+      for (auto& ring : registry.m_rings) {
+        while (ring->m_writing.load(std::memory_order_seq_cst)) {
+          std::this_thread::yield();
+        }
+      }
+    }
+
+    void WriteJsonString(std::ostream& stream, const char* text) {
+      stream << '"';
+      for (const char* character = text; *character != '\0'; character++) {
+        if (*character == '"' || *character == '\\') {
+          stream << '\\';
+        }
+        stream << *character;
+      }
+      stream << '"';
+    }
+
+  }
+
+  std::atomic<bool> Tracer::s_enabled{ false };
+
+  void Tracer::Enable(bool enabled) {
+    // Also makes sure the origin is taken before the first event, and keeps a dump in
+    // progress from restoring the old setting over this one
+    TraceRegistry& registry = GetTraceRegistry();
+    std::lock_guard<std::mutex> guard(registry.m_mutex);
+    s_enabled.store(enabled, std::memory_order_seq_cst);
+  }
+
+  void Tracer::Record(const char* name, Clock::time_point begin, Clock::time_point end, Clock::duration queued) {
+    TraceRing& ring = GetThreadRing();
+    Clock::time_point origin = GetTraceRegistry().m_origin;
+
+    // A scope that began before a dump disabled tracing is dropped rather than written
+    // under it
+    ring.m_writing.store(true, std::memory_order_seq_cst);
+    if (!s_enabled.load(std::memory_order_seq_cst)) {
+      ring.m_writing.store(false, std::memory_order_release);
+      return;
+    }
+
+    uint64_t head = ring.m_head.load(std::memory_order_relaxed);
+    TraceEvent& event = ring.m_events[head % NDTECH_TRACE_RING_SIZE];
+    event.m_name = name;
+    event.m_beginNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(begin - origin).count();
+    event.m_endNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(end - origin).count();
+    event.m_queuedNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(queued).count();
+    ring.m_head.store(head + 1, std::memory_order_release);
+    ring.m_writing.store(false, std::memory_order_release);
+  }
+
+  void Tracer::WriteChromeTrace(std::ostream& stream) {
+    TraceRegistry& registry = GetTraceRegistry();
+    std::lock_guard<std::mutex> guard(registry.m_mutex);
+
+    bool enabled = s_enabled.exchange(false, std::memory_order_seq_cst);
+    WaitForWriters(registry);
+
+    bool first = true;
+
+    std::ios::fmtflags flags = stream.flags();
+    std::streamsize precision = stream.precision();
+    // Microseconds with nanosecond digits, never in exponent form
+    stream << std::fixed << std::setprecision(3);
+
+    stream << "{\"traceEvents\":[";
+
+    for (auto& ring : registry.m_rings) {
+      uint64_t head = ring->m_head.load(std::memory_order_acquire);
+      uint64_t begin = head > NDTECH_TRACE_RING_SIZE ? head - NDTECH_TRACE_RING_SIZE : 0;
+
+      for (uint64_t index = begin; index < head; index++) {
+        const TraceEvent& event = ring->m_events[index % NDTECH_TRACE_RING_SIZE];
+
+        stream << (first ? "\n" : ",\n");
+        first = false;
+
+        stream << "{\"name\":";
+        WriteJsonString(stream, event.m_name);
+        stream << ",\"cat\":\"ndtech\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->m_threadId
+          << ",\"ts\":" << event.m_beginNanoseconds / 1000.0
+          << ",\"dur\":" << (event.m_endNanoseconds - event.m_beginNanoseconds) / 1000.0;
+        if (event.m_queuedNanoseconds >= 0) {
+          stream << ",\"args\":{\"queued_us\":" << event.m_queuedNanoseconds / 1000.0 << "}";
+        }
+        stream << "}";
+      }
+    }
+
+    stream << "\n],\"displayTimeUnit\":\"ns\"}\n";
+
+    stream.flags(flags);
+    stream.precision(precision);
+
+    s_enabled.store(enabled, std::memory_order_seq_cst);
+  }
+
+  bool Tracer::WriteChromeTrace(const std::string& path) {
+    std::ofstream stream(path, std::ios::out | std::ios::trunc);
+    if (!stream) {
+      return false;
+    }
+
+    WriteChromeTrace(stream);
+    return static_cast<bool>(stream);
+  }
+
+  void Tracer::Clear() {
+    TraceRegistry& registry = GetTraceRegistry();
+    std::lock_guard<std::mutex> guard(registry.m_mutex);
+
+    bool enabled = s_enabled.exchange(false, std::memory_order_seq_cst);
+    WaitForWriters(registry);
+
+    for (auto& ring : registry.m_rings) {
+      ring->m_head.store(0, std::memory_order_release);
+    }
+
+    s_enabled.store(enabled, std::memory_order_seq_cst);
+  }
+
+}
\ No newline at end of file
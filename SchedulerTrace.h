@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Build with NDTECH_SCHEDULER_TRACING=1 to compile the trace points in.  They still record
+// nothing until Tracer::Enable(true); while disabled each one costs a relaxed load and a
+// branch.  With the flag at 0 the macros expand to nothing.
+#ifndef NDTECH_SCHEDULER_TRACING
+#define NDTECH_SCHEDULER_TRACING 0
+#endif
+
+#ifndef NDTECH_TRACE_RING_SIZE
+#define NDTECH_TRACE_RING_SIZE 4096
+#endif
+
+#define NDTECH_TRACE_CONCATENATE_INNER(a, b) a##b
+#define NDTECH_TRACE_CONCATENATE(a, b) NDTECH_TRACE_CONCATENATE_INNER(a, b)
+
+#if NDTECH_SCHEDULER_TRACING
+// Records the rest of the enclosing scope as one event
+#define NDTECH_TRACE_SCOPE(name) ndtech::TraceScope NDTECH_TRACE_CONCATENATE(ndtechTraceScope, __LINE__)(name)
+// As NDTECH_TRACE_SCOPE, also recording how long the task waited since queuedTime
+#define NDTECH_TRACE_TASK(name, queuedTime) ndtech::TraceScope NDTECH_TRACE_CONCATENATE(ndtechTraceScope, __LINE__)(name, queuedTime)
+#else
+// Unevaluated, so the arguments still count as used
+#define NDTECH_TRACE_SCOPE(name) ((void)sizeof(name))
+#define NDTECH_TRACE_TASK(name, queuedTime) ((void)sizeof(name), (void)sizeof(queuedTime))
+#endif
+
+namespace ndtech {
+
+  struct TraceEvent {
+    // Must point at a string that outlives the trace, normally a literal
+    const char*   m_name;
+    int64_t       m_beginNanoseconds;
+    int64_t       m_endNanoseconds;
+    // Negative when the event is not a queued task
+    int64_t       m_queuedNanoseconds;
+  };
+
+  // Collects TraceEvents into one ring buffer per thread.  A thread only ever writes its
+  // own ring, so recording takes no lock; the registry mutex is taken once per thread, the
+  // first time it records.  When a ring is full the oldest events are overwritten.
+  struct Tracer {
+
+    using Clock = std::chrono::steady_clock;
+
+    static void Enable(bool enabled);
+
+    static bool IsEnabled() {
+      return s_enabled.load(std::memory_order_relaxed);
+    }
+
+    static void Record(const char* name, Clock::time_point begin, Clock::time_point end, Clock::duration queued);
+
+    // Writes every ring as Chrome trace-event JSON, loadable in chrome://tracing and
+    // Perfetto.  Safe while tasks are running: tracing is paused and the rings are left
+    // alone until the threads writing to them have finished, and events that end during
+    // the dump are not recorded.
+    static void WriteChromeTrace(std::ostream& stream);
+
+    static bool WriteChromeTrace(const std::string& path);
+
+    // Forgets every recorded event, pausing tracing as WriteChromeTrace does
+    static void Clear();
+
+  private:
+    static std::atomic<bool>  s_enabled;
+  };
+
+  struct TraceScope {
+
+    explicit TraceScope(const char* name)
+      : TraceScope(name, Tracer::Clock::time_point::max()) {
+    }
+
+    TraceScope(const char* name, Tracer::Clock::time_point queuedTime)
+      : m_name(nullptr) {
+      if (Tracer::IsEnabled()) {
+        m_name = name;
+        m_queuedTime = queuedTime;
+        m_begin = Tracer::Clock::now();
+      }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+    ~TraceScope() {
+      if (m_name != nullptr) {
+        Tracer::Clock::duration queued = m_queuedTime == Tracer::Clock::time_point::max() ? Tracer::Clock::duration(-1) : m_begin - m_queuedTime;
+        Tracer::Record(m_name, m_begin, Tracer::Clock::now(), queued);
+      }
+    }
+
+  private:
+    const char*                 m_name;
+    Tracer::Clock::time_point   m_queuedTime;
+    Tracer::Clock::time_point   m_begin;
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+
+namespace ndtech {
+
+  // Fixed-size block allocator.  Blocks are carved out of slabs that live as long as the
+  // pool, and free blocks sit on a lock-free stack, so once the pool has grown to its
+  // working-set size Allocate and Free touch no global allocator.  The free-list head packs
+  // a block index with a change counter, which keeps the compare and swap safe from ABA
+  // without relying on spare pointer bits.  Only growing a new slab takes a mutex.
+  // Allocate returns nullptr when MaxSlabs is exhausted so callers can fall back to new.
+  template <size_t BlockSize, size_t BlocksPerSlab = 1024, size_t MaxSlabs = 1024>
+  struct SlabPool {
+
+    SlabPool() = default;
+
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
+
+    ~SlabPool() {
+      for (size_t slabIndex = 0; slabIndex < m_slabCount.load(std::memory_order_acquire); slabIndex++) {
+        ::operator delete(m_slabs[slabIndex]);
+      }
+    }
+
+    void* Allocate() {
+      uint64_t head = m_freeHead.load(std::memory_order_acquire);
+
+      while (true) {
+        uint32_t index = static_cast<uint32_t>(head);
+        if (index == NullIndex) {
+          return Grow();
+        }
+
+        // The block may be handed out and reused before the exchange below, but slabs are
+        // never freed, so the read is safe and the counter makes the exchange fail
+        uint32_t next = BlockAt(index)->m_next.load(std::memory_order_relaxed);
+        uint64_t newHead = ((head >> 32) + 1) << 32 | next;
+
+        if (m_freeHead.compare_exchange_weak(head, newHead, std::memory_order_acq_rel, std::memory_order_acquire)) {
+          return BlockAt(index)->Payload();
+        }
+      }
+    }
+
+    void Free(void* payload) {
+      Push(Block::FromPayload(payload));
+    }
+
+    template <typename T, typename... Args>
+    T* New(Args&&... args) {
+      static_assert(sizeof(T) <= BlockSize, "ndtech::SlabPool::New T does not fit in a block");
+      void* payload = Allocate();
+      if (payload == nullptr) {
+        return nullptr;
+      }
+      return new (payload) T(std::forward<Args>(args)...);
+    }
+
+    template <typename T>
+    void Delete(T* item) {
+      item->~T();
+      Free(item);
+    }
+
+    size_t Capacity() const {
+      return m_slabCount.load(std::memory_order_acquire) * BlocksPerSlab;
+    }
+
+  private:
+    static constexpr uint32_t NullIndex = 0xFFFFFFFFu;
+    static constexpr size_t HeaderSize = alignof(std::max_align_t) > 8 ? alignof(std::max_align_t) : 8;
+    static constexpr size_t Stride = HeaderSize + ((BlockSize + alignof(std::max_align_t) - 1) / alignof(std::max_align_t)) * alignof(std::max_align_t);
+
+    struct Block {
+      std::atomic<uint32_t>   m_next;
+      uint32_t                m_index;
+
+      void* Payload() {
+        return reinterpret_cast<unsigned char*>(this) + HeaderSize;
+      }
+
+      static Block* FromPayload(void* payload) {
+        return reinterpret_cast<Block*>(static_cast<unsigned char*>(payload) - HeaderSize);
+      }
+    };
+
+    Block* BlockAt(uint32_t index) {
+      unsigned char* slab = m_slabs[index / BlocksPerSlab];
+      return reinterpret_cast<Block*>(slab + (index % BlocksPerSlab) * Stride);
+    }
+
+    void Push(Block* block) {
+      uint64_t head = m_freeHead.load(std::memory_order_acquire);
+      uint64_t newHead;
+      do {
+        block->m_next.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+        newHead = ((head >> 32) + 1) << 32 | block->m_index;
+      } while (!m_freeHead.compare_exchange_weak(head, newHead, std::memory_order_acq_rel, std::memory_order_acquire));
+    }
+
+    // Adds a slab, keeps its first block for the caller and frees the rest
+    void* Grow() {
+      std::lock_guard<std::mutex> guard(m_growMutex);
+
+      size_t slabIndex = m_slabCount.load(std::memory_order_relaxed);
+      if (slabIndex == MaxSlabs) {
+        return nullptr;
+      }
+
+      unsigned char* slab = static_cast<unsigned char*>(::operator new(Stride * BlocksPerSlab));
+      m_slabs[slabIndex] = slab;
+      m_slabCount.store(slabIndex + 1, std::memory_order_release);
+
+      for (size_t blockIndex = 0; blockIndex < BlocksPerSlab; blockIndex++) {
+        Block* block = new (slab + blockIndex * Stride) Block();
+        block->m_index = static_cast<uint32_t>(slabIndex * BlocksPerSlab + blockIndex);
+      }
+
+      for (size_t blockIndex = BlocksPerSlab - 1; blockIndex > 0; blockIndex--) {
+        Push(reinterpret_cast<Block*>(slab + blockIndex * Stride));
+      }
+
+      return reinterpret_cast<Block*>(slab)->Payload();
+    }
+
+    alignas(64) std::atomic<uint64_t>   m_freeHead{ NullIndex };
+    alignas(64) std::atomic<size_t>     m_slabCount{ 0 };
+    std::mutex                          m_growMutex;
+    unsigned char*                      m_slabs[MaxSlabs] = {};
+  };
+
+}
\ No newline at end of file
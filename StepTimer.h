@@ -19,7 +19,7 @@
 #include <exception>
 #endif 
 
-#if ML_DEVICE
+#if ML_DEVICE || NDTECH_HEADLESS
 #include <time.h>
 #include <cstdlib>
 #endif
@@ -52,6 +52,14 @@ namespace ndtech
     // Get the current framerate.
     inline int GetFramesPerSecond() const { return m_framesPerSecond; }
 
+    // Get the time left before the next update is due (fixed timestep) or before the
+    // target frame time is used up (variable timestep).  Negative when the frame is late.
+    inline int64_t GetFrameSlackTicks() const {
+      int64_t sinceTick = (GetTicks() - m_qpcLastTime) * TicksPerSecond / m_qpcFrequency;
+      return m_targetElapsedTicks - m_leftOverTicks - sinceTick;
+    }
+    inline double GetFrameSlackSeconds() const { return static_cast<double>(GetFrameSlackTicks()) / TicksPerSecond; }
+
     // Set whether to use fixed or variable timestep mode.
     void SetFixedTimeStep(bool isFixedTimestep);
 
@@ -70,7 +78,7 @@ namespace ndtech
     static const long TicksPerSecond = 10000000;
 #endif 
 
-#if ML_DEVICE
+#if ML_DEVICE || NDTECH_HEADLESS
     // Integer format represents time using 1,000,000,000 ticks per second.
     static const long TicksPerSecond = 1000000000;
 #endif
@@ -100,10 +108,9 @@ namespace ndtech
       return retval;
 #endif 
 
-#if ML_DEVICE
-      struct timespec now;
-      clock_gettime(CLOCK_MONOTONIC, &now);
-      return now.tv_nsec;
+#if ML_DEVICE || NDTECH_HEADLESS
+      // GetTicks reads CLOCK_MONOTONIC in nanoseconds
+      return 1000000000L;
 #endif
 
     }
@@ -130,7 +137,7 @@ namespace ndtech
       return int64_t(ticks.QuadPart);
 #endif 
 
-#if ML_DEVICE
+#if ML_DEVICE || NDTECH_HEADLESS
       struct timespec now;
       clock_gettime(CLOCK_MONOTONIC, &now);
       return (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+
+#include "TypeUtilities.h"
+
+namespace ndtech {
+
+  template <typename TestType>
+  using TestTypeHasReadsImpl = typename TestType::Reads;
+
+  template <typename TestType>
+  using TestTypeHasReads = ndtech::TypeUtilities::is_detected<TestTypeHasReadsImpl, TestType>;
+
+  template <typename TestType>
+  using TestTypeHasWritesImpl = typename TestType::Writes;
+
+  template <typename TestType>
+  using TestTypeHasWrites = ndtech::TypeUtilities::is_detected<TestTypeHasWritesImpl, TestType>;
+
+  namespace SystemScheduleImpl {
+
+    template <typename ComponentSystemType, bool HasReads = TestTypeHasReads<ComponentSystemType>::value>
+    struct ReadsOf {
+      using type = TypeUtilities::Typelist<>;
+    };
+
+    template <typename ComponentSystemType>
+    struct ReadsOf<ComponentSystemType, true> {
+      using type = typename ComponentSystemType::Reads;
+    };
+
+    template <typename ComponentSystemType, bool HasWrites = TestTypeHasWrites<ComponentSystemType>::value>
+    struct WritesOf {
+      using type = TypeUtilities::Typelist<>;
+    };
+
+    template <typename ComponentSystemType>
+    struct WritesOf<ComponentSystemType, true> {
+      using type = typename ComponentSystemType::Writes;
+    };
+
+    template <typename ComponentSystemType>
+    constexpr bool DeclaresAccess() {
+      return TestTypeHasReads<ComponentSystemType>::value || TestTypeHasWrites<ComponentSystemType>::value;
+    }
+
+    // By declared access alone
+    template <typename First, typename Second>
+    constexpr bool Races() {
+      using FirstReads = typename ReadsOf<First>::type;
+      using FirstWrites = typename WritesOf<First>::type;
+      using SecondReads = typename ReadsOf<Second>::type;
+      using SecondWrites = typename WritesOf<Second>::type;
+
+      return TypeUtilities::ContainsAnyOf(FirstWrites{}, SecondReads{}) ||
+        TypeUtilities::ContainsAnyOf(FirstWrites{}, SecondWrites{}) ||
+        TypeUtilities::ContainsAnyOf(SecondWrites{}, FirstReads{});
+    }
+
+    template <typename ConcurrentComponentSystems, typename First, typename Second>
+    constexpr bool Conflicts() {
+      if constexpr (DeclaresAccess<First>() && DeclaresAccess<Second>()) {
+        return Races<First, Second>();
+      }
+      else {
+        return !(TypeUtilities::TypelistContains<First, ConcurrentComponentSystems>() && TypeUtilities::TypelistContains<Second, ConcurrentComponentSystems>());
+      }
+    }
+
+    template <typename ConcurrentComponentSystems, typename First, typename... ComponentSystemTypes>
+    constexpr std::array<bool, sizeof...(ComponentSystemTypes)> ConflictRow() {
+      return { { Conflicts<ConcurrentComponentSystems, First, ComponentSystemTypes>()... } };
+    }
+
+    // Systems listed as concurrent must not contradict their own declarations
+    template <typename First, typename... ConcurrentComponentSystemTypes>
+    constexpr bool RacesNoConcurrentSystem() {
+      return ((std::is_same<First, ConcurrentComponentSystemTypes>::value ||
+        !(DeclaresAccess<First>() && DeclaresAccess<ConcurrentComponentSystemTypes>()) ||
+        !Races<First, ConcurrentComponentSystemTypes>()) && ...);
+    }
+
+    template <size_t SystemCount>
+    using ConflictMatrix = std::array<std::array<bool, SystemCount>, SystemCount>;
+
+    // Each system goes one phase after the latest earlier system it conflicts with
+    template <size_t SystemCount>
+    constexpr std::array<size_t, SystemCount> ComputePhases(const ConflictMatrix<SystemCount>& conflicts) {
+      std::array<size_t, SystemCount> phases{};
+      for (size_t system = 0; system < SystemCount; system++) {
+        for (size_t earlier = 0; earlier < system; earlier++) {
+          if (conflicts[system][earlier] && phases[earlier] + 1 > phases[system]) {
+            phases[system] = phases[earlier] + 1;
+          }
+        }
+      }
+      return phases;
+    }
+
+    template <size_t SystemCount>
+    constexpr size_t CountPhases(const std::array<size_t, SystemCount>& phases) {
+      size_t phaseCount = 0;
+      for (size_t system = 0; system < SystemCount; system++) {
+        if (phases[system] + 1 > phaseCount) {
+          phaseCount = phases[system] + 1;
+        }
+      }
+      return phaseCount;
+    }
+
+    // System indices grouped by phase, keeping ComponentSystems order within a phase
+    template <size_t SystemCount>
+    constexpr std::array<size_t, SystemCount> ComputeOrder(const std::array<size_t, SystemCount>& phases, size_t phaseCount) {
+      std::array<size_t, SystemCount> order{};
+      size_t next = 0;
+      for (size_t phase = 0; phase < phaseCount; phase++) {
+        for (size_t system = 0; system < SystemCount; system++) {
+          if (phases[system] == phase) {
+            order[next++] = system;
+          }
+        }
+      }
+      return order;
+    }
+
+    // Where each phase begins in the order, with one extra entry for the end
+    template <size_t PhaseCount, size_t SystemCount>
+    constexpr std::array<size_t, PhaseCount + 1> ComputePhaseStarts(const std::array<size_t, SystemCount>& phases) {
+      std::array<size_t, PhaseCount + 1> phaseStarts{};
+      for (size_t system = 0; system < SystemCount; system++) {
+        phaseStarts[phases[system] + 1]++;
+      }
+      for (size_t phase = 0; phase < PhaseCount; phase++) {
+        phaseStarts[phase + 1] += phaseStarts[phase];
+      }
+      return phaseStarts;
+    }
+
+    template <typename Components, typename... DeclaredTypes>
+    constexpr bool AreAllComponents(TypeUtilities::Typelist<DeclaredTypes...>) {
+      return (TypeUtilities::TypelistContains<DeclaredTypes, Components>() && ...);
+    }
+
+    // A declared type that is not a component, a misspelt or stale one, would never
+    // conflict with anything and let racing systems share a phase
+    template <typename Components, typename ComponentSystemType>
+    constexpr bool DeclaresOnlyComponents() {
+      return AreAllComponents<Components>(typename ReadsOf<ComponentSystemType>::type{}) &&
+        AreAllComponents<Components>(typename WritesOf<ComponentSystemType>::type{});
+    }
+
+  }
+
+  // Works out at compile time which component systems may update at the same time, from
+  // what each one declares it touches:
+  //
+  //   using Reads = TypeUtilities::Typelist<Transform>;
+  //   using Writes = TypeUtilities::Typelist<Velocity>;
+  //
+  // Two systems conflict when either writes something the other reads or writes.  A system
+  // that declares neither may touch anything, so it conflicts with every other system
+  // unless both are listed in ConcurrentComponentSystems.  Each system is put in the phase
+  // after the last earlier system it conflicts with, so conflicting systems keep their
+  // ComponentSystems order and the systems within a phase never race.  Everything a system
+  // declares must be one of Components, or the build fails.
+  template <typename Components, typename ComponentSystems, typename ConcurrentComponentSystems>
+  struct SystemSchedule;
+
+  template <typename Components, typename... ComponentSystemTypes, typename... ConcurrentComponentSystemTypes>
+  struct SystemSchedule<Components, TypeUtilities::Typelist<ComponentSystemTypes...>, TypeUtilities::Typelist<ConcurrentComponentSystemTypes...>> {
+
+    using ComponentSystems = TypeUtilities::Typelist<ComponentSystemTypes...>;
+    using ConcurrentComponentSystems = TypeUtilities::Typelist<ConcurrentComponentSystemTypes...>;
+
+    static_assert((SystemScheduleImpl::DeclaresOnlyComponents<Components, ComponentSystemTypes>() && ...), "ndtech::SystemSchedule a component system Reads or Writes a type that is not in Components");
+
+    static_assert((TypeUtilities::TypelistContains<ConcurrentComponentSystemTypes, ComponentSystems>() && ...), "ndtech::SystemSchedule ConcurrentComponentSystems must all be in ComponentSystems");
+
+    static constexpr size_t SystemCount = sizeof...(ComponentSystemTypes);
+
+    static_assert((SystemScheduleImpl::RacesNoConcurrentSystem<ConcurrentComponentSystemTypes, ConcurrentComponentSystemTypes...>() && ...), "ndtech::SystemSchedule two ConcurrentComponentSystems write a component the other reads or writes");
+
+    // Conflicts[first][second]
+    static constexpr SystemScheduleImpl::ConflictMatrix<SystemCount> Conflicts = { {
+      SystemScheduleImpl::ConflictRow<ConcurrentComponentSystems, ComponentSystemTypes, ComponentSystemTypes...>()...
+    } };
+
+    static constexpr std::array<size_t, SystemCount> Phases = SystemScheduleImpl::ComputePhases<SystemCount>(Conflicts);
+    static constexpr size_t PhaseCount = SystemScheduleImpl::CountPhases<SystemCount>(Phases);
+    static constexpr std::array<size_t, SystemCount> Order = SystemScheduleImpl::ComputeOrder<SystemCount>(Phases, PhaseCount);
+    static constexpr std::array<size_t, PhaseCount + 1> PhaseStarts = SystemScheduleImpl::ComputePhaseStarts<PhaseCount, SystemCount>(Phases);
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,219 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "SlabPool.h"
+
+#ifndef NDTECH_TASK_INLINE_SIZE
+#define NDTECH_TASK_INLINE_SIZE 64
+#endif
+
+namespace ndtech {
+
+  namespace TaskImpl {
+
+    // Size classes for callables too large to store inline.  Anything larger than the
+    // biggest class goes to the global allocator.
+    using SmallTaskPool = SlabPool<128>;
+    using MediumTaskPool = SlabPool<256>;
+    using LargeTaskPool = SlabPool<512>;
+
+    inline SmallTaskPool& GetSmallTaskPool() {
+      static SmallTaskPool pool;
+      return pool;
+    }
+
+    inline MediumTaskPool& GetMediumTaskPool() {
+      static MediumTaskPool pool;
+      return pool;
+    }
+
+    inline LargeTaskPool& GetLargeTaskPool() {
+      static LargeTaskPool pool;
+      return pool;
+    }
+
+    template <size_t Size>
+    void* AllocateBoxed(bool& pooled) {
+      void* storage = nullptr;
+      if constexpr (Size <= 128) {
+        storage = GetSmallTaskPool().Allocate();
+      }
+      else if constexpr (Size <= 256) {
+        storage = GetMediumTaskPool().Allocate();
+      }
+      else if constexpr (Size <= 512) {
+        storage = GetLargeTaskPool().Allocate();
+      }
+      pooled = storage != nullptr;
+      return pooled ? storage : ::operator new(Size);
+    }
+
+    template <size_t Size>
+    void FreeBoxed(void* storage, bool pooled) {
+      if (!pooled) {
+        ::operator delete(storage);
+      }
+      else if constexpr (Size <= 128) {
+        GetSmallTaskPool().Free(storage);
+      }
+      else if constexpr (Size <= 256) {
+        GetMediumTaskPool().Free(storage);
+      }
+      else if constexpr (Size <= 512) {
+        GetLargeTaskPool().Free(storage);
+      }
+    }
+
+  }
+
+  // Move-only replacement for std::function<void(void)>.  Callables up to InlineSize bytes
+  // (that are nothrow movable and not over-aligned) live inside the task; larger ones are
+  // boxed in a pooled slab block, so scheduling a task does not reach the global allocator
+  // once the pools are warm.
+  template <size_t InlineSize>
+  struct BasicTask {
+
+    static_assert(InlineSize >= 2 * sizeof(void*), "ndtech::BasicTask InlineSize must hold a boxed callable");
+
+    BasicTask() noexcept = default;
+
+    BasicTask(std::nullptr_t) noexcept {
+    }
+
+    template <typename CallableType,
+      typename DecayedType = std::decay_t<CallableType>,
+      typename = std::enable_if_t<!std::is_same<DecayedType, BasicTask>::value && std::is_invocable<DecayedType&>::value>>
+    BasicTask(CallableType&& callable) {
+      if constexpr (FitsInline<DecayedType>()) {
+        new (&m_storage) DecayedType(std::forward<CallableType>(callable));
+        m_operations = &InlineOperations<DecayedType>::s_operations;
+      }
+      else {
+        // Boxed storage is only aligned for max_align_t
+        static_assert(alignof(DecayedType) <= alignof(std::max_align_t), "ndtech::BasicTask callable is over-aligned");
+        bool pooled = false;
+        void* storage = TaskImpl::AllocateBoxed<sizeof(DecayedType)>(pooled);
+        Boxed<DecayedType>* boxed = new (&m_storage) Boxed<DecayedType>{ nullptr, pooled };
+        try {
+          boxed->m_callable = new (storage) DecayedType(std::forward<CallableType>(callable));
+        }
+        catch (...) {
+          TaskImpl::FreeBoxed<sizeof(DecayedType)>(storage, boxed->m_pooled);
+          throw;
+        }
+        m_operations = &BoxedOperations<DecayedType>::s_operations;
+      }
+    }
+
+    BasicTask(BasicTask&& other) noexcept {
+      MoveFrom(other);
+    }
+
+    BasicTask& operator=(BasicTask&& other) noexcept {
+      if (this != &other) {
+        Reset();
+        MoveFrom(other);
+      }
+      return *this;
+    }
+
+    BasicTask(const BasicTask&) = delete;
+    BasicTask& operator=(const BasicTask&) = delete;
+
+    ~BasicTask() {
+      Reset();
+    }
+
+    void operator()() {
+      m_operations->m_invoke(&m_storage);
+    }
+
+    explicit operator bool() const noexcept {
+      return m_operations != nullptr;
+    }
+
+    void Reset() noexcept {
+      if (m_operations != nullptr) {
+        m_operations->m_destroy(&m_storage);
+        m_operations = nullptr;
+      }
+    }
+
+  private:
+    struct Operations {
+      void(*m_invoke)(void* storage);
+      void(*m_move)(void* destination, void* source) noexcept;
+      void(*m_destroy)(void* storage) noexcept;
+    };
+
+    template <typename CallableType>
+    static constexpr bool FitsInline() {
+      return sizeof(CallableType) <= InlineSize
+        && alignof(CallableType) <= alignof(std::max_align_t)
+        && std::is_nothrow_move_constructible<CallableType>::value;
+    }
+
+    // m_pooled records whether the block came from a size-class pool or, because the class
+    // was exhausted or too small, from the global allocator
+    template <typename CallableType>
+    struct Boxed {
+      CallableType*   m_callable;
+      bool            m_pooled;
+    };
+
+    template <typename CallableType>
+    struct InlineOperations {
+      static void Invoke(void* storage) {
+        (*static_cast<CallableType*>(storage))();
+      }
+
+      static void Move(void* destination, void* source) noexcept {
+        new (destination) CallableType(std::move(*static_cast<CallableType*>(source)));
+        static_cast<CallableType*>(source)->~CallableType();
+      }
+
+      static void Destroy(void* storage) noexcept {
+        static_cast<CallableType*>(storage)->~CallableType();
+      }
+
+      static constexpr Operations s_operations{ &Invoke, &Move, &Destroy };
+    };
+
+    template <typename CallableType>
+    struct BoxedOperations {
+      static void Invoke(void* storage) {
+        (*static_cast<Boxed<CallableType>*>(storage)->m_callable)();
+      }
+
+      static void Move(void* destination, void* source) noexcept {
+        new (destination) Boxed<CallableType>(*static_cast<Boxed<CallableType>*>(source));
+      }
+
+      static void Destroy(void* storage) noexcept {
+        Boxed<CallableType>* boxed = static_cast<Boxed<CallableType>*>(storage);
+        boxed->m_callable->~CallableType();
+        TaskImpl::FreeBoxed<sizeof(CallableType)>(boxed->m_callable, boxed->m_pooled);
+      }
+
+      static constexpr Operations s_operations{ &Invoke, &Move, &Destroy };
+    };
+
+    void MoveFrom(BasicTask& other) noexcept {
+      if (other.m_operations != nullptr) {
+        other.m_operations->m_move(&m_storage, &other.m_storage);
+        m_operations = other.m_operations;
+        other.m_operations = nullptr;
+      }
+    }
+
+    alignas(std::max_align_t) unsigned char   m_storage[InlineSize];
+    const Operations*                         m_operations = nullptr;
+  };
+
+  using Task = BasicTask<NDTECH_TASK_INLINE_SIZE>;
+
+}
\ No newline at end of file
@@ -0,0 +1,166 @@
+#include "pch.h"
+#include "TaskGraph.h"
+
+#include <algorithm>
+#include <cassert>
+#include <exception>
+
+namespace ndtech {
+
+  TaskGraph::NodeId TaskGraph::AddNode(Task task) {
+    m_tasks.push_back(std::move(task));
+    m_successors.emplace_back();
+    m_predecessors.emplace_back();
+    m_prepared = false;
+    return m_tasks.size() - 1;
+  }
+
+  void TaskGraph::AddEdge(NodeId before, NodeId after) {
+    assert(before < m_tasks.size() && after < m_tasks.size());
+
+    m_successors[before].push_back(after);
+    m_predecessors[after].push_back(before);
+    m_prepared = false;
+  }
+
+  bool TaskGraph::Run(Scheduler& scheduler) {
+    if (!Prepare()) {
+      return false;
+    }
+
+    if (m_tasks.empty()) {
+      m_lastRunTime = Clock::duration::zero();
+      m_criticalPathTime = Clock::duration::zero();
+      return true;
+    }
+
+    m_scheduler = &scheduler;
+
+    for (NodeId node = 0; node < m_tasks.size(); node++) {
+      m_pendingPredecessors[node].store(static_cast<uint32_t>(m_predecessors[node].size()), std::memory_order_relaxed);
+    }
+    m_remainingNodes.store(m_tasks.size(), std::memory_order_relaxed);
+    m_failed.store(false, std::memory_order_relaxed);
+    m_done = false;
+
+    Clock::time_point start = Clock::now();
+
+    for (NodeId root : m_roots) {
+      Schedule(root);
+    }
+
+    std::exception_ptr exception;
+    {
+      std::unique_lock<std::mutex> lock(m_doneMutex);
+      m_doneConditionVariable.wait(lock, [this]() { return m_done; });
+      exception = std::move(m_exception);
+      m_exception = nullptr;
+    }
+
+    m_lastRunTime = Clock::now() - start;
+    ComputeCriticalPath();
+
+    if (exception) {
+      std::rethrow_exception(exception);
+    }
+
+    return true;
+  }
+
+  // A node the scheduler turns away runs here instead, or Run would wait for it forever
+  void TaskGraph::Schedule(NodeId node) {
+    if (m_scheduler->AddTask([this, node]() { RunNode(node); }).IsRejected()) {
+      RunNode(node);
+    }
+  }
+
+  // Rebuilds the roots, the topological order and the per-node counters after the graph
+  // has changed.  Kahn's algorithm, so a cycle shows up as nodes that are never ordered.
+  bool TaskGraph::Prepare() {
+    if (m_prepared) {
+      return m_acyclic;
+    }
+
+    size_t nodeCount = m_tasks.size();
+
+    m_roots.clear();
+    m_order.clear();
+    m_order.reserve(nodeCount);
+
+    std::vector<size_t> inDegrees(nodeCount);
+    for (NodeId node = 0; node < nodeCount; node++) {
+      inDegrees[node] = m_predecessors[node].size();
+      if (inDegrees[node] == 0) {
+        m_roots.push_back(node);
+        m_order.push_back(node);
+      }
+    }
+
+    for (size_t index = 0; index < m_order.size(); index++) {
+      for (NodeId successor : m_successors[m_order[index]]) {
+        if (--inDegrees[successor] == 0) {
+          m_order.push_back(successor);
+        }
+      }
+    }
+
+    m_pendingPredecessors = std::make_unique<std::atomic<uint32_t>[]>(nodeCount);
+    m_durations.assign(nodeCount, Clock::duration::zero());
+    m_pathTimes.assign(nodeCount, Clock::duration::zero());
+
+    m_prepared = true;
+    m_acyclic = m_order.size() == nodeCount;
+
+    if (!m_acyclic) {
+      LOG(WARNING) << "ndtech::TaskGraph has a cycle, " << nodeCount - m_order.size() << " nodes can never run";
+    }
+
+    return m_acyclic;
+  }
+
+  // Once a node has thrown, the rest are only counted off, so the graph still drains and
+  // Run can return
+  void TaskGraph::RunNode(NodeId node) {
+    Clock::time_point start = Clock::now();
+    if (!m_failed.load(std::memory_order_acquire)) {
+      try {
+        m_tasks[node]();
+      }
+      catch (...) {
+        std::lock_guard<std::mutex> lock(m_doneMutex);
+        if (!m_exception) {
+          m_exception = std::current_exception();
+        }
+        m_failed.store(true, std::memory_order_release);
+      }
+    }
+    m_durations[node] = Clock::now() - start;
+
+    for (NodeId successor : m_successors[node]) {
+      if (m_pendingPredecessors[successor].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        Schedule(successor);
+      }
+    }
+
+    if (m_remainingNodes.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      std::lock_guard<std::mutex> lock(m_doneMutex);
+      m_done = true;
+      m_doneConditionVariable.notify_all();
+    }
+  }
+
+  void TaskGraph::ComputeCriticalPath() {
+    m_criticalPathTime = Clock::duration::zero();
+
+    for (NodeId node : m_order) {
+      Clock::duration longestPredecessor = Clock::duration::zero();
+      for (NodeId predecessor : m_predecessors[node]) {
+        longestPredecessor = std::max(longestPredecessor, m_pathTimes[predecessor]);
+      }
+
+      m_pathTimes[node] = longestPredecessor + m_durations[node];
+      m_criticalPathTime = std::max(m_criticalPathTime, m_pathTimes[node]);
+    }
+  }
+
+}
\ No newline at end of file
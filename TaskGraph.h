@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Scheduler.h"
+#include "Task.h"
+
+namespace ndtech {
+
+  // A reusable DAG of tasks.  Build it once with AddNode and AddEdge, then call Run every
+  // frame: nodes whose predecessors have finished are handed to the Scheduler, so
+  // independent nodes run concurrently in WorkStealing mode.  The structure is only
+  // rebuilt after the graph changes, so repeated runs do not allocate.
+  //
+  // Run blocks the calling thread, so it must not be called from a task running on the
+  // same Scheduler in SingleThread mode.
+  struct TaskGraph {
+
+    using NodeId = size_t;
+    using Clock = steady_clock;
+
+    TaskGraph() = default;
+
+    TaskGraph(const TaskGraph&) = delete;
+    TaskGraph& operator=(const TaskGraph&) = delete;
+
+    NodeId AddNode(Task task);
+
+    // after runs only once before has finished
+    void AddEdge(NodeId before, NodeId after);
+
+    // Runs every node once and waits for all of them.  Returns false, without running
+    // anything, if the graph has a cycle.  A node the Scheduler's QueueFullPolicy rejects
+    // runs on the thread that tried to add it.  If a node throws, nodes that have not
+    // started yet are skipped, and once the running ones have finished Run rethrows the
+    // first exception.
+    bool Run(Scheduler& scheduler);
+
+    size_t NodeCount() const { return m_tasks.size(); }
+
+    // Wall time of the last run
+    Clock::duration LastRunTime() const { return m_lastRunTime; }
+
+    // Sum of node durations along the slowest dependency chain of the last run, the lower
+    // bound on LastRunTime no matter how many workers there are
+    Clock::duration CriticalPathTime() const { return m_criticalPathTime; }
+
+    Clock::duration NodeTime(NodeId node) const { return m_durations[node]; }
+
+  private:
+    bool Prepare();
+
+    void Schedule(NodeId node);
+
+    void RunNode(NodeId node);
+
+    void ComputeCriticalPath();
+
+    Scheduler*                                  m_scheduler = nullptr;
+    std::vector<Task>                           m_tasks;
+    std::vector<std::vector<NodeId>>            m_successors;
+    std::vector<std::vector<NodeId>>            m_predecessors;
+    std::vector<NodeId>                         m_roots;
+    // Nodes in topological order, for the critical path pass
+    std::vector<NodeId>                         m_order;
+    std::unique_ptr<std::atomic<uint32_t>[]>    m_pendingPredecessors;
+    std::vector<Clock::duration>                m_durations;
+    std::vector<Clock::duration>                m_pathTimes;
+    bool                                        m_prepared = false;
+    bool                                        m_acyclic = false;
+
+    std::atomic<size_t>                         m_remainingNodes{ 0 };
+    std::atomic<bool>                           m_failed{ false };
+    std::mutex                                  m_doneMutex;
+    std::condition_variable                     m_doneConditionVariable;
+    bool                                        m_done = false;
+    // The first exception a node threw, guarded by m_doneMutex
+    std::exception_ptr                          m_exception;
+
+    Clock::duration                             m_lastRunTime{ 0 };
+    Clock::duration                             m_criticalPathTime{ 0 };
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,368 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#endif
+
+#include "Task.h"
+#include "WakeSignal.h"
+
+namespace ndtech {
+
+  // Registered on a slot by whoever waits for its task.  m_resume is called once, by the
+  // thread that runs or drops the task, after the task's slot has been released.
+  struct TaskWaiter {
+    void(*m_resume)(TaskWaiter* waiter) = nullptr;
+  };
+
+  // Holds the tasks that have a TaskHandle.  A slot's state packs a generation with the
+  // task's status, and the generation moves on when the slot is released, so a handle is
+  // just (table, index, generation): once the generation has changed the task is finished,
+  // and no per-task reference count is needed.  Slots are recycled through a lock-free
+  // free list like SlabPool's; only adding a chunk takes a mutex.
+  struct TaskSlotTable {
+
+    static constexpr size_t SlotsPerChunk = 1024;
+    static constexpr size_t MaxChunks = 1024;
+
+    TaskSlotTable() = default;
+
+    TaskSlotTable(const TaskSlotTable&) = delete;
+    TaskSlotTable& operator=(const TaskSlotTable&) = delete;
+
+    // Moves function into a free slot.  Returns false, leaving function alone, when every
+    // slot is in use.
+    bool Acquire(Task& function, uint32_t& index, uint32_t& generation) {
+      index = PopFree();
+      if (index == NullIndex) {
+        return false;
+      }
+
+      TaskSlot& slot = SlotAt(index);
+      slot.m_function = std::move(function);
+      generation = static_cast<uint32_t>(slot.m_state.load(std::memory_order_relaxed) >> 32);
+      slot.m_state.store(Pack(generation, Pending), std::memory_order_release);
+      m_queuedTasks.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+
+    // Tasks that have not started, been cancelled or been dropped.  Running tasks are not
+    // counted, so a task that queues more work does not hold a place while it waits.
+    size_t QueuedTasks() const {
+      return m_queuedTasks.load(std::memory_order_relaxed);
+    }
+
+    // signal, when set, is notified whenever a task stops being queued
+    void SetReleaseSignal(WakeSignal* signal) {
+      m_releaseSignal = signal;
+    }
+
+    // Runs the slot's task unless it was cancelled, then releases the slot
+    void Run(uint32_t index, uint32_t generation) {
+      TaskSlot& slot = SlotAt(index);
+      uint64_t state = slot.m_state.load(std::memory_order_acquire);
+
+      while ((state & StatusMask) == Pending) {
+        if (slot.m_state.compare_exchange_weak(state, (state & ~StatusMask) | Running, std::memory_order_acq_rel, std::memory_order_acquire)) {
+          TaskDequeued();
+          slot.m_function();
+          break;
+        }
+      }
+
+      Release(index, generation);
+    }
+
+    // Releases the slot of a task that was never run
+    void Drop(uint32_t index, uint32_t generation) {
+      Release(index, generation);
+    }
+
+    // Succeeds only while the task is still queued
+    bool Cancel(uint32_t index, uint32_t generation) {
+      TaskSlot& slot = SlotAt(index);
+      uint64_t state = slot.m_state.load(std::memory_order_acquire);
+
+      while (Generation(state) == generation && (state & StatusMask) == Pending) {
+        if (slot.m_state.compare_exchange_weak(state, (state & ~StatusMask) | Cancelled, std::memory_order_acq_rel, std::memory_order_acquire)) {
+          TaskDequeued();
+          return true;
+        }
+      }
+
+      return false;
+    }
+
+    // True once the task has run or has been cancelled
+    bool IsDone(uint32_t index, uint32_t generation) const {
+      uint64_t state = SlotAt(index).m_state.load(std::memory_order_acquire);
+      return Generation(state) != generation || (state & StatusMask) == Cancelled;
+    }
+
+    // Registers waiter to be resumed when the slot is released.  Returns false if it
+    // already has been.  Only one waiter per task is supported.
+    bool Wait(uint32_t index, uint32_t generation, TaskWaiter* waiter) {
+      TaskSlot& slot = SlotAt(index);
+      uint64_t state = slot.m_state.load(std::memory_order_acquire);
+
+      while (Generation(state) == generation) {
+        assert((state & WaiterBit) == 0);
+        if (slot.m_state.compare_exchange_weak(state, state | WaiterBit, std::memory_order_acq_rel, std::memory_order_acquire)) {
+          // Release spins until this store lands before it frees the slot
+          slot.m_waiter.store(waiter, std::memory_order_release);
+          return true;
+        }
+      }
+
+      return false;
+    }
+
+  private:
+    static constexpr uint32_t NullIndex = 0xFFFFFFFFu;
+
+    static constexpr uint64_t Pending = 0;
+    static constexpr uint64_t Running = 1;
+    static constexpr uint64_t Cancelled = 2;
+    static constexpr uint64_t Free = 3;
+    static constexpr uint64_t StatusMask = 3;
+    static constexpr uint64_t WaiterBit = 4;
+
+    struct TaskSlot {
+      std::atomic<uint64_t>       m_state{ Free };
+      std::atomic<uint32_t>       m_nextFree{ NullIndex };
+      std::atomic<TaskWaiter*>    m_waiter{ nullptr };
+      Task                        m_function;
+    };
+
+    static uint64_t Pack(uint32_t generation, uint64_t status) {
+      return static_cast<uint64_t>(generation) << 32 | status;
+    }
+
+    static uint32_t Generation(uint64_t state) {
+      return static_cast<uint32_t>(state >> 32);
+    }
+
+    TaskSlot& SlotAt(uint32_t index) const {
+      return m_chunks[index / SlotsPerChunk][index % SlotsPerChunk];
+    }
+
+    // Bumps the generation, which finishes every handle to the task, and hands the slot
+    // back to the free list
+    void Release(uint32_t index, uint32_t generation) {
+      TaskSlot& slot = SlotAt(index);
+      slot.m_function.Reset();
+
+      uint64_t state = slot.m_state.exchange(Pack(generation + 1, Free), std::memory_order_acq_rel);
+
+      TaskWaiter* waiter = nullptr;
+      if (state & WaiterBit) {
+        while ((waiter = slot.m_waiter.exchange(nullptr, std::memory_order_acquire)) == nullptr) {
+          std::this_thread::yield();
+        }
+      }
+
+      PushFree(index);
+
+      // Run and Cancel have already dequeued the task unless it is being dropped unrun
+      if ((state & StatusMask) == Pending) {
+        TaskDequeued();
+      }
+
+      if (waiter != nullptr) {
+        waiter->m_resume(waiter);
+      }
+    }
+
+    void TaskDequeued() {
+      m_queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+      if (m_releaseSignal != nullptr) {
+        m_releaseSignal->Notify();
+      }
+    }
+
+    uint32_t PopFree() {
+      uint64_t head = m_freeHead.load(std::memory_order_acquire);
+
+      while (true) {
+        uint32_t index = static_cast<uint32_t>(head);
+        if (index == NullIndex) {
+          return Grow();
+        }
+
+        uint32_t next = SlotAt(index).m_nextFree.load(std::memory_order_relaxed);
+        uint64_t newHead = ((head >> 32) + 1) << 32 | next;
+
+        if (m_freeHead.compare_exchange_weak(head, newHead, std::memory_order_acq_rel, std::memory_order_acquire)) {
+          return index;
+        }
+      }
+    }
+
+    void PushFree(uint32_t index) {
+      TaskSlot& slot = SlotAt(index);
+      uint64_t head = m_freeHead.load(std::memory_order_acquire);
+      uint64_t newHead;
+      do {
+        slot.m_nextFree.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+        newHead = ((head >> 32) + 1) << 32 | index;
+      } while (!m_freeHead.compare_exchange_weak(head, newHead, std::memory_order_acq_rel, std::memory_order_acquire));
+    }
+
+    // Adds a chunk, keeps its first slot for the caller and frees the rest
+    uint32_t Grow() {
+      std::lock_guard<std::mutex> guard(m_growMutex);
+
+      size_t chunkIndex = m_chunkCount.load(std::memory_order_relaxed);
+      if (chunkIndex == MaxChunks) {
+        return NullIndex;
+      }
+
+      m_chunks[chunkIndex] = std::make_unique<TaskSlot[]>(SlotsPerChunk);
+      m_chunkCount.store(chunkIndex + 1, std::memory_order_release);
+
+      uint32_t firstIndex = static_cast<uint32_t>(chunkIndex * SlotsPerChunk);
+      for (uint32_t index = firstIndex + SlotsPerChunk - 1; index > firstIndex; index--) {
+        PushFree(index);
+      }
+
+      return firstIndex;
+    }
+
+    alignas(64) std::atomic<uint64_t>     m_freeHead{ NullIndex };
+    alignas(64) std::atomic<size_t>       m_chunkCount{ 0 };
+    alignas(64) std::atomic<size_t>       m_queuedTasks{ 0 };
+    WakeSignal*                           m_releaseSignal = nullptr;
+    std::mutex                            m_growMutex;
+    std::unique_ptr<TaskSlot[]>           m_chunks[MaxChunks];
+  };
+
+  // Queued in place of a task that has a slot.  Destroying it without running it, as Join
+  // does with whatever is left in the queues, releases the slot so waiters are not stranded.
+  struct SlotTask {
+
+    SlotTask(TaskSlotTable* slots, uint32_t index, uint32_t generation)
+      : m_slots(slots),
+      m_index(index),
+      m_generation(generation) {
+    }
+
+    SlotTask(SlotTask&& other) noexcept
+      : m_slots(other.m_slots),
+      m_index(other.m_index),
+      m_generation(other.m_generation) {
+      other.m_slots = nullptr;
+    }
+
+    SlotTask(const SlotTask&) = delete;
+    SlotTask& operator=(const SlotTask&) = delete;
+    SlotTask& operator=(SlotTask&&) = delete;
+
+    ~SlotTask() {
+      if (m_slots != nullptr) {
+        m_slots->Drop(m_index, m_generation);
+      }
+    }
+
+    void operator()() {
+      TaskSlotTable* slots = m_slots;
+      m_slots = nullptr;
+      slots->Run(m_index, m_generation);
+    }
+
+  private:
+    TaskSlotTable*    m_slots;
+    uint32_t          m_index;
+    uint32_t          m_generation;
+  };
+
+  // Returned by Scheduler::AddTask.  Copyable and trivially cheap; it must not outlive the
+  // Scheduler that issued it.  An empty handle, returned when the slot table is full or
+  // the task was rejected, reports its task as done and cannot cancel it.
+  struct TaskHandle {
+
+    TaskHandle() = default;
+
+    static TaskHandle Rejected() {
+      TaskHandle handle;
+      handle.m_rejected = true;
+      return handle;
+    }
+
+    TaskHandle(TaskSlotTable* slots, uint32_t index, uint32_t generation)
+      : m_slots(slots),
+      m_index(index),
+      m_generation(generation) {
+    }
+
+    // Stops the task from running if it has not started.  A cancelled task is dropped
+    // when the scheduler reaches it in its queue.
+    bool Cancel() const {
+      return m_slots != nullptr && m_slots->Cancel(m_index, m_generation);
+    }
+
+    bool IsDone() const {
+      return m_slots == nullptr || m_slots->IsDone(m_index, m_generation);
+    }
+
+    explicit operator bool() const {
+      return m_slots != nullptr;
+    }
+
+    // The scheduler's queue was full and its QueueFullPolicy turned the task away
+    bool IsRejected() const {
+      return m_rejected;
+    }
+
+#if defined(__cpp_impl_coroutine)
+    struct Awaiter;
+
+    Awaiter operator co_await() const;
+#endif
+
+  private:
+    TaskSlotTable*    m_slots = nullptr;
+    uint32_t          m_index = 0;
+    uint32_t          m_generation = 0;
+    bool              m_rejected = false;
+  };
+
+#if defined(__cpp_impl_coroutine)
+  // co_await handle suspends until the task has run or been dropped.  The coroutine
+  // resumes on the thread that finished the task.
+  struct TaskHandle::Awaiter : TaskWaiter {
+    TaskHandle                  m_handle;
+    std::coroutine_handle<>     m_coroutine;
+
+    bool await_ready() const {
+      return m_handle.IsDone();
+    }
+
+    bool await_suspend(std::coroutine_handle<> coroutine) {
+      m_coroutine = coroutine;
+      m_resume = &Resume;
+      return m_handle.m_slots->Wait(m_handle.m_index, m_handle.m_generation, this);
+    }
+
+    void await_resume() const {
+    }
+
+    static void Resume(TaskWaiter* waiter) {
+      static_cast<Awaiter*>(waiter)->m_coroutine.resume();
+    }
+  };
+
+  inline TaskHandle::Awaiter TaskHandle::operator co_await() const {
+    Awaiter awaiter;
+    awaiter.m_handle = *this;
+    return awaiter;
+  }
+#endif
+
+}
\ No newline at end of file
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+namespace ndtech {
+
+  // An entry in one of the Scheduler's timed queues.  The sequence number keeps tasks
+  // scheduled for the same time in the order they were added.
+  template <typename PayloadType, typename TimePointType>
+  struct TimedEntry {
+    PayloadType     m_payload;
+    TimePointType   m_time;
+    uint64_t        m_sequence = 0;
+  };
+
+  // Binary min-heap ordered by time.  Push and Pop are O(log N), Top is O(1).
+  template <typename EntryType>
+  struct TaskHeap {
+
+    using TimePointType = decltype(std::declval<EntryType>().m_time);
+
+    void Push(EntryType entry) {
+      m_entries.push_back(std::move(entry));
+      std::push_heap(m_entries.begin(), m_entries.end(), Later);
+    }
+
+    const EntryType& Top() const {
+      return m_entries.front();
+    }
+
+    EntryType Pop() {
+      std::pop_heap(m_entries.begin(), m_entries.end(), Later);
+      EntryType entry = std::move(m_entries.back());
+      m_entries.pop_back();
+      return entry;
+    }
+
+    // Moves every entry due at or before now into ready, earliest first.
+    void PopReady(TimePointType now, std::vector<EntryType>& ready) {
+      while (!m_entries.empty() && m_entries.front().m_time <= now) {
+        ready.push_back(Pop());
+      }
+    }
+
+    bool NextTime(TimePointType& nextTime) const {
+      if (m_entries.empty()) {
+        return false;
+      }
+      nextTime = m_entries.front().m_time;
+      return true;
+    }
+
+    bool Empty() const { return m_entries.empty(); }
+    size_t Size() const { return m_entries.size(); }
+    void Reserve(size_t capacity) { m_entries.reserve(capacity); }
+
+  private:
+    static bool Later(const EntryType& l, const EntryType& r) {
+      if (l.m_time != r.m_time) {
+        return l.m_time > r.m_time;
+      }
+      return l.m_sequence > r.m_sequence;
+    }
+
+    std::vector<EntryType> m_entries;
+  };
+
+  // Hierarchical timer wheel (4 levels of 256 slots).  Push is O(1), and popping ready
+  // entries is O(1) amortized per entry plus one slot visit per elapsed tick.  Entries
+  // are bucketed by tick, so tasks due within the same tick run in slot order rather
+  // than strict time order.
+  template <typename EntryType>
+  struct TimerWheel {
+
+    using TimePointType = decltype(std::declval<EntryType>().m_time);
+    using DurationType = typename TimePointType::duration;
+
+    static constexpr size_t SlotBits = 8;
+    static constexpr size_t SlotsPerLevel = size_t(1) << SlotBits;
+    static constexpr size_t SlotMask = SlotsPerLevel - 1;
+    static constexpr size_t Levels = 4;
+
+    TimerWheel(TimePointType origin, DurationType resolution)
+      : m_origin(origin),
+      m_resolution(resolution) {
+    }
+
+    void Push(EntryType entry) {
+      Insert(std::move(entry));
+      m_size++;
+    }
+
+    // Moves every entry due at or before now into ready.
+    void PopReady(TimePointType now, std::vector<EntryType>& ready) {
+      uint64_t targetTick = TickFor(now);
+
+      if (m_size == 0) {
+        m_currentTick = std::max(m_currentTick, targetTick);
+        return;
+      }
+
+      while (m_currentTick < targetTick && m_size > 0) {
+        auto& slot = m_levels[0][m_currentTick & SlotMask];
+        for (auto& entry : slot) {
+          ready.push_back(std::move(entry));
+        }
+        m_size -= slot.size();
+        slot.clear();
+
+        m_currentTick++;
+        Cascade();
+      }
+
+      if (m_size == 0) {
+        m_currentTick = std::max(m_currentTick, targetTick);
+        return;
+      }
+
+      // The current tick is only partially elapsed, so take just the entries already due
+      auto& slot = m_levels[0][m_currentTick & SlotMask];
+      for (size_t index = 0; index < slot.size();) {
+        if (slot[index].m_time <= now) {
+          ready.push_back(std::move(slot[index]));
+          slot[index] = std::move(slot.back());
+          slot.pop_back();
+          m_size--;
+        }
+        else {
+          index++;
+        }
+      }
+    }
+
+    // The earliest time at which an entry may be due.  Entries in the current tick report
+    // their exact time; later slots report the start of their tick, which is never later
+    // than the entries they hold.  A higher level can hold an entry due before the first
+    // occupied level-0 slot, so every level is checked.
+    bool NextTime(TimePointType& nextTime) const {
+      if (m_size == 0) {
+        return false;
+      }
+
+      const auto& currentSlot = m_levels[0][m_currentTick & SlotMask];
+      if (!currentSlot.empty()) {
+        nextTime = currentSlot.front().m_time;
+        for (const auto& entry : currentSlot) {
+          nextTime = std::min(nextTime, entry.m_time);
+        }
+        return true;
+      }
+
+      bool found = false;
+      for (size_t level = 0; level < Levels; level++) {
+        uint64_t shift = level * SlotBits;
+        uint64_t levelTick = m_currentTick >> shift;
+        // An entry a full rotation ahead shares the current slot index, hence the inclusive bound
+        for (size_t offset = 1; offset <= SlotsPerLevel; offset++) {
+          if (!m_levels[level][(levelTick + offset) & SlotMask].empty()) {
+            TimePointType slotTime = TimeFor((levelTick + offset) << shift);
+            if (!found || slotTime < nextTime) {
+              nextTime = slotTime;
+              found = true;
+            }
+            break;
+          }
+        }
+      }
+
+      return found;
+    }
+
+    bool Empty() const { return m_size == 0; }
+    size_t Size() const { return m_size; }
+
+  private:
+    uint64_t TickFor(TimePointType time) const {
+      if (time <= m_origin) {
+        return 0;
+      }
+      return static_cast<uint64_t>((time - m_origin) / m_resolution);
+    }
+
+    TimePointType TimeFor(uint64_t tick) const {
+      return m_origin + m_resolution * static_cast<typename DurationType::rep>(tick);
+    }
+
+    void Insert(EntryType entry) {
+      uint64_t tick = std::max(TickFor(entry.m_time), m_currentTick);
+      uint64_t delta = tick - m_currentTick;
+
+      size_t level = 0;
+      while (level < Levels - 1 && delta >= (uint64_t(1) << (SlotBits * (level + 1)))) {
+        level++;
+      }
+
+      // Anything beyond the range of the top level waits in its furthest slot and is
+      // re-bucketed every time that slot cascades.
+      uint64_t maxDelta = (uint64_t(1) << (SlotBits * Levels)) - 1;
+      if (delta > maxDelta) {
+        tick = m_currentTick + maxDelta;
+      }
+
+      m_levels[level][(tick >> (SlotBits * level)) & SlotMask].push_back(std::move(entry));
+    }
+
+    // When the lower level wraps, redistribute the matching slot of the level above.
+    void Cascade() {
+      for (size_t level = 1; level < Levels; level++) {
+        if ((m_currentTick & ((uint64_t(1) << (SlotBits * level)) - 1)) != 0) {
+          return;
+        }
+
+        // Swapping through a member keeps both buffers' capacity, so a warm wheel
+        // cascades without allocating
+        auto& slot = m_levels[level][(m_currentTick >> (SlotBits * level)) & SlotMask];
+        m_cascade.swap(slot);
+        for (auto& entry : m_cascade) {
+          Insert(std::move(entry));
+        }
+        m_cascade.clear();
+      }
+    }
+
+    TimePointType                                                   m_origin;
+    DurationType                                                    m_resolution;
+    uint64_t                                                        m_currentTick = 0;
+    size_t                                                          m_size = 0;
+    std::array<std::array<std::vector<EntryType>, SlotsPerLevel>, Levels> m_levels;
+    std::vector<EntryType>                                          m_cascade;
+  };
+
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <map>
 #include <string>
 #include <tuple>
 #include <typeinfo>
@@ -97,17 +98,13 @@ namespace ndtech {
         using type = D;
       };
 
-      template <typename D, template <typename...> class Check, typename... Args>
-      auto detect_check(char)
-        ->detect_impl<std::false_type, D>;
+      // A partial specialization, because with GCC the overloaded function form never
+      // detected anything when Check was an alias with a fixed number of parameters
+      template <typename D, typename Void, template <typename...> class Check, typename... Args>
+      struct detect : detect_impl<std::false_type, D> {};
 
       template <typename D, template <typename...> class Check, typename... Args>
-      auto detect_check(int)
-        -> decltype(void_t<Check<Args...>>(),
-          detect_impl<std::true_type, Check<Args...>>{});
-
-      template <typename D, typename Void, template <typename...> class Check, typename... Args>
-      struct detect : decltype(detect_check<D, Check, Args...>(0)) {};
+      struct detect<D, void_t<Check<Args...>>, Check, Args...> : detect_impl<std::true_type, Check<Args...>> {};
 
 
       template<typename... Ts>
@@ -870,7 +867,7 @@ namespace ndtech {
     }
 
     template<typename... TsToTest, typename... TsToTestAgainst>
-    bool ContainsAnyOf(Typelist<TsToTest...> tsToTest, Typelist<TsToTestAgainst...> tsToTestAgainst) {
+    constexpr bool ContainsAnyOf(Typelist<TsToTest...> tsToTest, Typelist<TsToTestAgainst...> tsToTestAgainst) {
       return Impl::ContainsAnyOfImpl<Typelist<TsToTest...>, Typelist<TsToTestAgainst...>>::value;
     };
 
@@ -0,0 +1,90 @@
+#include "pch.h"
+#include "WakeSignal.h"
+
+#include <algorithm>
+#include <thread>
+
+#if defined(__linux__)
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <Windows.h>
+#pragma comment(lib, "Synchronization.lib")
+#endif
+
+namespace ndtech {
+
+  void WakeSignal::Notify() {
+    m_epoch.fetch_add(1, std::memory_order_seq_cst);
+    if (m_parked.load(std::memory_order_seq_cst) != 0) {
+      Unpark();
+    }
+  }
+
+  void WakeSignal::WaitUntil(uint32_t epoch, Clock::time_point deadline, Clock::duration spin) {
+    Clock::time_point now = Clock::now();
+
+    // Spin briefly first, more work often arrives right behind the last batch
+    Clock::time_point spinUntil = std::min(deadline, now + spin);
+    while (now < spinUntil) {
+      if (Epoch() != epoch) {
+        return;
+      }
+      std::this_thread::yield();
+      now = Clock::now();
+    }
+
+    while (now < deadline) {
+      if (Epoch() != epoch) {
+        return;
+      }
+
+      Clock::duration timeout = deadline - spin - now;
+      if (timeout > Clock::duration::zero()) {
+        Park(epoch, timeout);
+      }
+      else {
+        std::this_thread::yield();
+      }
+      now = Clock::now();
+    }
+  }
+
+  // May return early, WaitUntil loops until the epoch or the deadline says otherwise
+  void WakeSignal::Park(uint32_t epoch, Clock::duration timeout) {
+    m_parked.fetch_add(1, std::memory_order_seq_cst);
+
+#if defined(__linux__)
+    auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(timeout).count();
+    timespec relativeTimeout;
+    relativeTimeout.tv_sec = static_cast<time_t>(nanoseconds / 1000000000);
+    relativeTimeout.tv_nsec = static_cast<long>(nanoseconds % 1000000000);
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&m_epoch), FUTEX_WAIT_PRIVATE, epoch, &relativeTimeout, nullptr, 0);
+#elif defined(_WIN32)
+    DWORD milliseconds = static_cast<DWORD>(std::chrono::duration_cast<std::chrono::milliseconds>(timeout).count());
+    WaitOnAddress(&m_epoch, &epoch, sizeof(epoch), milliseconds);
+#else
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_conditionVariable.wait_for(lock, timeout, [this, epoch]() { return Epoch() != epoch; });
+    }
+#endif
+
+    m_parked.fetch_sub(1, std::memory_order_seq_cst);
+  }
+
+  void WakeSignal::Unpark() {
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&m_epoch), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#elif defined(_WIN32)
+    WakeByAddressAll(&m_epoch);
+#else
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_conditionVariable.notify_all();
+#endif
+  }
+
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#if !defined(__linux__) && !defined(_WIN32)
+#include <condition_variable>
+#include <mutex>
+#endif
+
+namespace ndtech {
+
+  // Lets threads sleep until a deadline or until another thread signals them.  A signal
+  // bumps an epoch and a sleeper only parks while the epoch is still the one it read
+  // before deciding to sleep, so a signal racing with going to sleep is never lost.
+  // Parking is a futex on Linux and WaitOnAddress on Windows; elsewhere it falls back to a
+  // condition variable.
+  struct WakeSignal {
+
+    using Clock = std::chrono::steady_clock;
+
+    WakeSignal() = default;
+
+    WakeSignal(const WakeSignal&) = delete;
+    WakeSignal& operator=(const WakeSignal&) = delete;
+
+    uint32_t Epoch() const {
+      return m_epoch.load(std::memory_order_seq_cst);
+    }
+
+    // Never blocks, and only makes a system call when a waiter is parked
+    void Notify();
+
+    // Returns once the epoch has moved past epoch or deadline has been reached.  The
+    // waiter spins for up to spin before parking, and parks only until spin ahead of the
+    // deadline, spinning the rest, so kernel timer slack does not show up as lateness.
+    void WaitUntil(uint32_t epoch, Clock::time_point deadline, Clock::duration spin);
+
+  private:
+    void Park(uint32_t epoch, Clock::duration timeout);
+
+    void Unpark();
+
+    std::atomic<uint32_t>       m_epoch{ 0 };
+    std::atomic<uint32_t>       m_parked{ 0 };
+#if !defined(__linux__) && !defined(_WIN32)
+    std::mutex                  m_mutex;
+    std::condition_variable     m_conditionVariable;
+#endif
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace ndtech {
+
+  // Chase-Lev work-stealing deque (using the C11 memory orderings from Le, Pop, Cohen and
+  // Zappa Nardelli, "Correct and Efficient Work-Stealing for Weak Memory Models").
+  // The owning thread pushes and pops at the bottom, any other thread may steal from the
+  // top.  ItemType must be trivially copyable, in practice a pointer.
+  template <typename ItemType>
+  struct WorkStealingDeque {
+
+    WorkStealingDeque(size_t initialCapacity = 256) {
+      size_t capacity = 1;
+      while (capacity < initialCapacity) {
+        capacity <<= 1;
+      }
+      m_buffers.push_back(std::make_unique<Buffer>(capacity));
+      m_buffer.store(m_buffers.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    // Owner thread only
+    void Push(ItemType item) {
+      int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+      int64_t top = m_top.load(std::memory_order_acquire);
+      Buffer* buffer = m_buffer.load(std::memory_order_relaxed);
+
+      if (bottom - top > static_cast<int64_t>(buffer->m_capacity) - 1) {
+        buffer = Grow(buffer, top, bottom);
+      }
+
+      buffer->Put(bottom, item);
+      std::atomic_thread_fence(std::memory_order_release);
+      m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    // Owner thread only
+    bool Pop(ItemType& item) {
+      int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+      Buffer* buffer = m_buffer.load(std::memory_order_relaxed);
+      m_bottom.store(bottom, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      int64_t top = m_top.load(std::memory_order_relaxed);
+
+      if (top > bottom) {
+        // empty
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        return false;
+      }
+
+      item = buffer->Get(bottom);
+
+      if (top == bottom) {
+        // last item, race the thieves for it
+        bool won = m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        return won;
+      }
+
+      return true;
+    }
+
+    // Any thread
+    bool Steal(ItemType& item) {
+      int64_t top = m_top.load(std::memory_order_acquire);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      int64_t bottom = m_bottom.load(std::memory_order_acquire);
+
+      if (top >= bottom) {
+        return false;
+      }
+
+      Buffer* buffer = m_buffer.load(std::memory_order_acquire);
+      item = buffer->Get(top);
+      return m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+
+    bool Empty() const {
+      int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+      int64_t top = m_top.load(std::memory_order_relaxed);
+      return top >= bottom;
+    }
+
+  private:
+    struct Buffer {
+      Buffer(size_t capacity)
+        : m_capacity(capacity),
+        m_mask(capacity - 1),
+        m_items(new std::atomic<ItemType>[capacity]) {
+      }
+
+      void Put(int64_t index, ItemType item) {
+        m_items[index & m_mask].store(item, std::memory_order_relaxed);
+      }
+
+      ItemType Get(int64_t index) {
+        return m_items[index & m_mask].load(std::memory_order_relaxed);
+      }
+
+      size_t                                  m_capacity;
+      size_t                                  m_mask;
+      std::unique_ptr<std::atomic<ItemType>[]> m_items;
+    };
+
+    // Thieves may still be reading the old buffer, so it is retired rather than freed
+    Buffer* Grow(Buffer* buffer, int64_t top, int64_t bottom) {
+      m_buffers.push_back(std::make_unique<Buffer>(buffer->m_capacity * 2));
+      Buffer* newBuffer = m_buffers.back().get();
+      for (int64_t index = top; index < bottom; index++) {
+        newBuffer->Put(index, buffer->Get(index));
+      }
+      m_buffer.store(newBuffer, std::memory_order_release);
+      return newBuffer;
+    }
+
+    alignas(64) std::atomic<int64_t>          m_top{ 0 };
+    alignas(64) std::atomic<int64_t>          m_bottom{ 0 };
+    alignas(64) std::atomic<Buffer*>          m_buffer{ nullptr };
+    std::vector<std::unique_ptr<Buffer>>      m_buffers;
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,193 @@
+#include "pch.h"
+#include "WorkerPool.h"
+#include "SchedulerTrace.h"
+
+namespace ndtech {
+
+  namespace {
+    thread_local WorkerPool*  t_workerPool = nullptr;
+    thread_local size_t       t_workerIndex = 0;
+  }
+
+  WorkerPool::WorkerPool(size_t workerCount, LaneCounters* counters)
+    : m_counters(counters) {
+    if (workerCount == 0) {
+      workerCount = 1;
+    }
+
+    // Every deque has to exist before any worker starts stealing
+    for (size_t workerIndex = 0; workerIndex < workerCount; workerIndex++) {
+      m_workers.push_back(std::make_unique<Worker>());
+    }
+
+    for (size_t workerIndex = 0; workerIndex < workerCount; workerIndex++) {
+      m_workers[workerIndex]->m_thread = std::thread{ &WorkerPool::Run, this, workerIndex };
+    }
+  }
+
+  WorkerPool::~WorkerPool() {
+    Join();
+  }
+
+  void WorkerPool::Submit(Task task) {
+    TaskNode* taskPointer = NewTaskNode(std::move(task));
+
+    if (t_workerPool == this) {
+      m_workers[t_workerIndex]->m_deque.Push(taskPointer);
+    }
+    else {
+      std::lock_guard<std::mutex> guard(m_injectedMutex);
+      m_injected.push_back(taskPointer);
+      m_injectedCount.fetch_add(1, std::memory_order_release);
+    }
+
+    WakeWorker();
+  }
+
+  bool WorkerPool::OnWorkerThread() const {
+    return t_workerPool == this;
+  }
+
+  void WorkerPool::Join() {
+    if (m_done.exchange(true)) {
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> guard(m_idleMutex);
+      m_idleConditionVariable.notify_all();
+    }
+
+    for (auto& worker : m_workers) {
+      if (worker->m_thread.joinable()) {
+        worker->m_thread.join();
+      }
+    }
+
+    // Anything submitted after the workers drained is dropped
+    for (size_t index = m_injectedHead; index < m_injected.size(); index++) {
+      DeleteTaskNode(m_injected[index]);
+    }
+    m_injected.clear();
+    m_injectedHead = 0;
+  }
+
+  void WorkerPool::Run(size_t workerIndex) {
+    t_workerPool = this;
+    t_workerIndex = workerIndex;
+
+    TaskNode* task = nullptr;
+
+    while (true) {
+      if (FindTask(workerIndex, task)) {
+        {
+          NDTECH_TRACE_TASK("Worker task", task->m_enqueueTime);
+          if (m_counters != nullptr) {
+            m_counters->RecordTask(std::chrono::steady_clock::now() - task->m_enqueueTime);
+          }
+          task->m_task();
+        }
+        DeleteTaskNode(task);
+        continue;
+      }
+
+      if (m_done.load(std::memory_order_acquire)) {
+        break;
+      }
+
+      std::unique_lock<std::mutex> lock(m_idleMutex);
+      m_idleWorkers.fetch_add(1, std::memory_order_seq_cst);
+
+      // Pairs with the fence in WakeWorker.  Either this finds the work just pushed, or
+      // its producer sees this worker idle and notifies under m_idleMutex, which the
+      // wait only gives up once it is waiting.  So an idle worker sleeps until there is
+      // work instead of polling for it.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (!HasVisibleWork() && !m_done.load(std::memory_order_acquire)) {
+        m_idleConditionVariable.wait(lock);
+      }
+
+      m_idleWorkers.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    t_workerPool = nullptr;
+  }
+
+  bool WorkerPool::FindTask(size_t workerIndex, TaskNode*& task) {
+    if (m_workers[workerIndex]->m_deque.Pop(task)) {
+      return true;
+    }
+
+    if (m_injectedCount.load(std::memory_order_acquire) > 0) {
+      std::lock_guard<std::mutex> guard(m_injectedMutex);
+      if (m_injectedHead < m_injected.size()) {
+        task = m_injected[m_injectedHead++];
+
+        // Rewind once drained rather than popping the front, the vector keeps its capacity
+        if (m_injectedHead == m_injected.size()) {
+          m_injected.clear();
+          m_injectedHead = 0;
+        }
+        else if (m_injectedHead >= 1024 && m_injectedHead * 2 >= m_injected.size()) {
+          // Producers are keeping up with the workers, drop the consumed prefix in place
+          m_injected.erase(m_injected.begin(), m_injected.begin() + m_injectedHead);
+          m_injectedHead = 0;
+        }
+
+        m_injectedCount.fetch_sub(1, std::memory_order_release);
+        return true;
+      }
+    }
+
+    size_t workerCount = m_workers.size();
+    for (size_t offset = 1; offset < workerCount; offset++) {
+      if (m_workers[(workerIndex + offset) % workerCount]->m_deque.Steal(task)) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  bool WorkerPool::HasVisibleWork() {
+    if (m_injectedCount.load(std::memory_order_acquire) > 0) {
+      return true;
+    }
+
+    for (auto& worker : m_workers) {
+      if (!worker->m_deque.Empty()) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  WorkerPool::TaskNode* WorkerPool::NewTaskNode(Task task) {
+    void* storage = m_taskNodePool.Allocate();
+    if (storage != nullptr) {
+      return new (storage) TaskNode{ std::move(task), std::chrono::steady_clock::now(), true };
+    }
+    return new TaskNode{ std::move(task), std::chrono::steady_clock::now(), false };
+  }
+
+  void WorkerPool::DeleteTaskNode(TaskNode* node) {
+    if (node->m_pooled) {
+      m_taskNodePool.Delete(node);
+    }
+    else {
+      delete node;
+    }
+  }
+
+  // Called after every push, to the injection queue or to a worker's own deque, so that
+  // work another worker could steal never waits for a worker to wake up by itself
+  void WorkerPool::WakeWorker() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_idleWorkers.load(std::memory_order_seq_cst) > 0) {
+      std::lock_guard<std::mutex> guard(m_idleMutex);
+      m_idleConditionVariable.notify_one();
+    }
+  }
+
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "SchedulerCounters.h"
+#include "SlabPool.h"
+#include "Task.h"
+#include "WorkStealingDeque.h"
+
+namespace ndtech {
+
+  // A fixed set of worker threads, each with its own Chase-Lev deque.  Tasks submitted
+  // from a worker go to that worker's deque; tasks from any other thread go to a shared
+  // injection queue.  Idle workers take from their own deque, then the injection queue,
+  // then steal from the other workers.
+  struct WorkerPool {
+
+    // counters, when given, record each task's queueing latency
+    WorkerPool(size_t workerCount, LaneCounters* counters = nullptr);
+
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void Submit(Task task);
+
+    void Join();
+
+    size_t WorkerCount() const { return m_workers.size(); }
+
+    // True on this pool's worker threads, where waiting on the pool's own work can deadlock
+    bool OnWorkerThread() const;
+
+  private:
+    struct TaskNode {
+      Task                                    m_task;
+      std::chrono::steady_clock::time_point   m_enqueueTime;
+      bool                                    m_pooled;
+    };
+
+    struct Worker {
+      WorkStealingDeque<TaskNode*>      m_deque;
+      std::thread                       m_thread;
+    };
+
+    TaskNode* NewTaskNode(Task task);
+    void DeleteTaskNode(TaskNode* node);
+
+    void Run(size_t workerIndex);
+
+    bool FindTask(size_t workerIndex, TaskNode*& task);
+
+    bool HasVisibleWork();
+
+    void WakeWorker();
+
+    LaneCounters*                         m_counters;
+    SlabPool<sizeof(TaskNode)>            m_taskNodePool;
+    std::vector<std::unique_ptr<Worker>>  m_workers;
+    std::mutex                            m_injectedMutex;
+    std::vector<TaskNode*>                m_injected;
+    size_t                                m_injectedHead = 0;
+    std::atomic<size_t>                   m_injectedCount{ 0 };
+    std::mutex                            m_idleMutex;
+    std::condition_variable               m_idleConditionVariable;
+    std::atomic<size_t>                   m_idleWorkers{ 0 };
+    std::atomic<bool>                     m_done{ false };
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace ndtech {
+  namespace bench {
+
+    using Clock = std::chrono::steady_clock;
+
+    inline double MillisecondsSince(Clock::time_point start) {
+      return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // Sorts samples in place
+    template <typename SampleType>
+    SampleType Percentile(std::vector<SampleType>& samples, double percentile) {
+      if (samples.empty()) {
+        return SampleType{};
+      }
+      std::sort(samples.begin(), samples.end());
+      size_t index = static_cast<size_t>(percentile / 100.0 * (samples.size() - 1) + 0.5);
+      return samples[index];
+    }
+
+    // The first argument, when given, overrides defaultValue, so a run can be made smaller
+    inline size_t SizeArgument(int argc, char** argv, int index, size_t defaultValue) {
+      return argc > index ? static_cast<size_t>(std::strtoull(argv[index], nullptr, 10)) : defaultValue;
+    }
+
+  }
+}
\ No newline at end of file
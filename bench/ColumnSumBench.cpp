@@ -0,0 +1,93 @@
+#include "MultiItemStore.h"
+#include "BenchUtilities.h"
+
+#include <cstdint>
+
+// Sums a float column of a MultiItemStore, through a View of the column and, for
+// comparison, through GetItem one id at a time, which was the only way to read the store
+// before it had column views
+//
+//   ColumnSumBench [rows]
+
+using namespace ndtech;
+using namespace ndtech::bench;
+
+using Store = MultiItemStore<uint32_t, float, uint32_t>;
+
+float SumInOrder(ColumnSpan<const float> column) {
+  float sum = 0.0f;
+  for (float value : column) {
+    sum += value;
+  }
+  return sum;
+}
+
+// Eight independent sums, which the compiler can keep in one vector register without
+// being allowed to reassociate float adds
+float SumInLanes(ColumnSpan<const float> column) {
+  float lanes[8] = {};
+  size_t index = 0;
+  for (; index + 8 <= column.size(); index += 8) {
+    for (size_t lane = 0; lane < 8; lane++) {
+      lanes[lane] += column[index + lane];
+    }
+  }
+  float sum = 0.0f;
+  for (; index < column.size(); index++) {
+    sum += column[index];
+  }
+  for (float lane : lanes) {
+    sum += lane;
+  }
+  return sum;
+}
+
+template <typename SumType>
+void Measure(const char* name, size_t rowCount, SumType&& sum) {
+  // Once to warm the caches and the page tables, then timed
+  volatile float result = sum();
+  auto start = Clock::now();
+  result = sum();
+  double milliseconds = MillisecondsSince(start);
+  std::printf("%-28s %9.2f ms   %6.2f GB/s   sum %.0f\n", name, milliseconds, rowCount * sizeof(float) / milliseconds / 1e6, static_cast<float>(result));
+}
+
+int main(int argc, char** argv) {
+  size_t rowCount = SizeArgument(argc, argv, 1, 10000000);
+
+  Store store;
+  boost::fibers::fiber fiber;
+  store.RunOn(fiber);
+
+  Store::Batch batch;
+  batch.m_itemActions.reserve(rowCount);
+  for (size_t row = 0; row < rowCount; row++) {
+    batch.AddItem(static_cast<uint32_t>(row), static_cast<float>(row % 4), static_cast<uint32_t>(row));
+  }
+  store.Commit(std::move(batch));
+  while (store.Size() != rowCount) {
+    boost::this_fiber::yield();
+  }
+
+  {
+    auto view = store.View<float>();
+    std::printf("%zu rows, float column at %p, %zu byte aligned\n", view.Size(), static_cast<const void*>(view.Get<float>().data()),
+      reinterpret_cast<uintptr_t>(view.Get<float>().data()) % Store::ColumnAlignment == 0 ? Store::ColumnAlignment : size_t{ 0 });
+
+    Measure("View, in order", rowCount, [&]() { return SumInOrder(view.Get<float>()); });
+    Measure("View, eight lanes", rowCount, [&]() { return SumInLanes(view.Get<float>()); });
+  }
+
+  Measure("GetItem per id", rowCount, [&]() {
+    float sum = 0.0f;
+    for (size_t row = 0; row < rowCount; row++) {
+      sum += std::get<0>(store.GetItem(static_cast<uint32_t>(row)));
+    }
+    return sum;
+  });
+
+  store.Stop();
+  fiber.join();
+
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,110 @@
+#include "ApplicationSettings.h"
+#include "App.h"
+#include "BenchUtilities.h"
+
+// One App frame's UpdateComponentSystems over 1M entities, each with a Motion and a Health
+// component.  The two systems declare disjoint writes, so they share a phase, and are
+// updated one component at a time or, when ParallelSafe, in chunks over the scheduler's
+// workers.
+//
+//   ComponentUpdateBench [entities] [frames] [workers]
+
+using namespace ndtech;
+using namespace ndtech::bench;
+
+struct Motion {
+  float m_position[3];
+  float m_velocity[3];
+};
+
+struct Health {
+  float m_value;
+  float m_regeneration;
+};
+
+template <bool Parallel>
+struct MotionSystem {
+  using Component = Motion;
+  using Reads = TypeUtilities::Typelist<>;
+  using Writes = TypeUtilities::Typelist<Motion>;
+  static constexpr bool ParallelSafe = Parallel;
+
+  void UpdateComponent(Motion* motion, BaseApp*) {
+    for (int axis = 0; axis < 3; axis++) {
+      motion->m_velocity[axis] *= 0.999f;
+      motion->m_position[axis] += motion->m_velocity[axis] * (1.0f / 60.0f);
+    }
+  }
+};
+
+template <bool Parallel>
+struct HealthSystem {
+  using Component = Health;
+  using Reads = TypeUtilities::Typelist<>;
+  using Writes = TypeUtilities::Typelist<Health>;
+  static constexpr bool ParallelSafe = Parallel;
+
+  void UpdateComponent(Health* health, BaseApp*) {
+    health->m_value = std::min(health->m_value + health->m_regeneration, 100.0f);
+  }
+};
+
+template <bool Parallel>
+using BenchSettings = ApplicationSettings<TypeUtilities::Typelist<Motion, Health>, TypeUtilities::Typelist<MotionSystem<Parallel>, HealthSystem<Parallel>>>;
+
+template <bool Parallel>
+struct BenchApp : App<BenchSettings<Parallel>, BenchApp<Parallel>> {
+  explicit BenchApp(SchedulerSettings schedulerSettings)
+    : App<BenchSettings<Parallel>, BenchApp<Parallel>>(schedulerSettings) {
+  }
+};
+
+template <bool Parallel>
+void Measure(const char* name, SchedulerSettings schedulerSettings, size_t entityCount, size_t frameCount) {
+  using AppType = BenchApp<Parallel>;
+  static_assert(AppType::Schedule::PhaseCount == 1, "the two systems should share a phase");
+
+  AppType app(schedulerSettings);
+  app.Initialize();
+
+  for (size_t entity = 0; entity < entityCount; entity++) {
+    auto& added = app.AddEntity();
+    app.AddComponent(added, Motion{ { 0.0f, 0.0f, 0.0f }, { 1.0f, 2.0f, 3.0f } });
+    app.AddComponent(added, Health{ 50.0f, 0.01f });
+  }
+
+  app.UpdateComponentSystems(typename AppType::ComponentSystems{});
+
+  std::vector<double> frames;
+  for (size_t frame = 0; frame < frameCount; frame++) {
+    auto start = Clock::now();
+    app.UpdateComponentSystems(typename AppType::ComponentSystems{});
+    frames.push_back(MillisecondsSince(start));
+  }
+
+  float checksum = 0.0f;
+  app.template View<Motion>([&checksum](auto&, Motion& motion) { checksum += motion.m_position[0]; });
+
+  double median = Percentile(frames, 50.0);
+  std::printf("%-44s p50 %7.2f ms   best %7.2f ms   (checksum %.0f)\n", name, median, frames.front(), checksum);
+  app.m_scheduler.Join();
+}
+
+int main(int argc, char** argv) {
+  size_t entityCount = SizeArgument(argc, argv, 1, 1000000);
+  size_t frameCount = SizeArgument(argc, argv, 2, 20);
+  size_t workerCount = SizeArgument(argc, argv, 3, 4);
+
+  SchedulerSettings singleThread;
+  SchedulerSettings workStealing;
+  workStealing.m_mode = SchedulerMode::WorkStealing;
+  workStealing.m_workerCount = workerCount;
+
+  std::printf("%zu entities, %zu frames, %zu workers\n", entityCount, frameCount, workerCount);
+  Measure<false>("one component at a time, SingleThread", singleThread, entityCount, frameCount);
+  Measure<false>("one component at a time, WorkStealing", workStealing, entityCount, frameCount);
+  Measure<true>("ParallelSafe chunks, SingleThread", singleThread, entityCount, frameCount);
+  Measure<true>("ParallelSafe chunks, WorkStealing", workStealing, entityCount, frameCount);
+
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include "ApplicationSettings.h"
+#include "App.h"
+#include "BenchUtilities.h"
+
+#include <fstream>
+#include <random>
+
+// Spawn and despawn churn against App's entity slots.  A population of live entities, each
+// with one component, is kept steady while random ones are removed and new ones added, and
+// the entity storage and resident memory are reported as it goes.  With removed slots
+// reused both stay flat however many operations run.
+//
+//   EntitySoakBench [operations] [population]
+
+using namespace ndtech;
+using namespace ndtech::bench;
+
+struct Lifetime {
+  uint64_t m_spawnedAt = 0;
+};
+
+struct SoakSettings : ApplicationSettings<TypeUtilities::Typelist<Lifetime>, TypeUtilities::Typelist<>> {
+};
+
+struct SoakApp : App<SoakSettings, SoakApp> {
+};
+
+size_t ResidentKilobytes() {
+  std::ifstream statm("/proc/self/statm");
+  size_t pages = 0;
+  size_t residentPages = 0;
+  statm >> pages >> residentPages;
+  return residentPages * 4;
+}
+
+int main(int argc, char** argv) {
+  size_t operationCount = SizeArgument(argc, argv, 1, 10000000);
+  size_t population = SizeArgument(argc, argv, 2, 100000);
+
+  SoakApp app;
+  app.Initialize();
+
+  std::vector<SoakApp::EntityHandle> live;
+  live.reserve(population);
+  for (size_t entity = 0; entity < population; entity++) {
+    auto& added = app.AddEntity();
+    app.AddComponent(added, Lifetime{ 0 });
+    live.push_back(app.GetHandle(added));
+  }
+
+  std::printf("%zu operations on a population of %zu\n", operationCount, population);
+  std::printf("%12s %12s %12s %12s %12s\n", "operations", "slots", "capacity", "resident KB", "ns per op");
+
+  std::mt19937_64 random(1);
+  size_t staleRejected = 0;
+  size_t reportEvery = operationCount / 10;
+  auto start = Clock::now();
+
+  for (size_t operation = 1; operation <= operationCount; operation++) {
+    // Remove a random live entity, then spawn one in its place
+    if (operation % 2 == 1) {
+      size_t victim = random() % live.size();
+      SoakApp::EntityHandle handle = live[victim];
+      app.RemoveEntity(handle);
+      staleRejected += app.GetEntity(handle) == nullptr && !app.RemoveEntity(handle);
+      live[victim] = live.back();
+      live.pop_back();
+    }
+    else {
+      auto& added = app.AddEntity();
+      app.AddComponent(added, Lifetime{ operation });
+      live.push_back(app.GetHandle(added));
+    }
+
+    if (reportEvery > 0 && operation % reportEvery == 0) {
+      double nanoseconds = MillisecondsSince(start) * 1e6 / reportEvery;
+      std::printf("%12zu %12zu %12zu %12zu %12.1f\n", operation, static_cast<size_t>(app.m_freeEntityIndex), static_cast<size_t>(app.m_entitiesCapacity), ResidentKilobytes(), nanoseconds);
+      start = Clock::now();
+    }
+  }
+
+  std::printf("stale handles rejected: %zu of %zu removals\n", staleRejected, operationCount / 2);
+  app.m_scheduler.Join();
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+#include "NamedItemStore.h"
+#include "BenchUtilities.h"
+
+#include <ctime>
+#include <memory>
+#include <string>
+#include <thread>
+
+// The NamedItemStore apply loop: CPU burnt while there is nothing to apply, with as many
+// stores running as the MagicLeap RenderingSystem has, and how long an AddItem takes to
+// become visible to a reader.  The stores run on fibers of the benchmark's thread, as
+// they do under RunOn in the apps; the latency is measured again with the store on a
+// thread of its own.
+//
+//   ItemStoreApplyBench [stores] [idleMilliseconds] [adds]
+
+using namespace ndtech;
+using namespace ndtech::bench;
+
+using Store = NamedItemStore<int, std::string>;
+
+double ProcessCpuMilliseconds() {
+  timespec now;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+  return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+}
+
+void MeasureAddToVisible(Store& store, size_t addCount, const char* where) {
+  std::vector<double> latencies;
+  latencies.reserve(addCount);
+
+  for (size_t index = 0; index < addCount; index++) {
+    std::string name = std::string(where) + std::to_string(index);
+
+    auto start = Clock::now();
+    store.WaitForVersion(store.AddItem(name, static_cast<int>(index)));
+    latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+  }
+
+  std::printf("add to visible, store %s, %zu adds: p50 %.1f us   p99 %.1f us   p99.9 %.1f us\n", where, addCount, Percentile(latencies, 50.0), Percentile(latencies, 99.0), Percentile(latencies, 99.9));
+}
+
+int main(int argc, char** argv) {
+  size_t storeCount = SizeArgument(argc, argv, 1, 4);
+  size_t idleMilliseconds = SizeArgument(argc, argv, 2, 1000);
+  size_t addCount = SizeArgument(argc, argv, 3, 10000);
+
+  {
+    std::vector<std::unique_ptr<Store>> stores;
+    std::vector<boost::fibers::fiber> fibers(storeCount);
+    for (size_t index = 0; index < storeCount; index++) {
+      stores.push_back(std::make_unique<Store>());
+      stores.back()->RunOn(fibers[index]);
+    }
+
+    double cpuBefore = ProcessCpuMilliseconds();
+    auto wallBefore = Clock::now();
+    boost::this_fiber::sleep_for(std::chrono::milliseconds(idleMilliseconds));
+    double cpuUsed = ProcessCpuMilliseconds() - cpuBefore;
+    double wallUsed = MillisecondsSince(wallBefore);
+
+    std::printf("%zu idle stores: %.2f ms CPU in %.0f ms, %.2f%% of one core\n", storeCount, cpuUsed, wallUsed, 100.0 * cpuUsed / wallUsed);
+
+    MeasureAddToVisible(*stores.front(), addCount, "on a fiber");
+
+    for (size_t index = 0; index < storeCount; index++) {
+      stores[index]->Stop();
+      fibers[index].join();
+    }
+  }
+
+  {
+    Store store;
+    std::thread thread(&Store::Run, &store);
+
+    MeasureAddToVisible(store, addCount / 10, "on its own thread");
+
+    store.Stop();
+    thread.join();
+  }
+
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,109 @@
+#include "NamedItemStore.h"
+#include "MultiItemStore.h"
+#include "BenchUtilities.h"
+
+#include <string>
+
+// Loads of many items into a NamedItemStore and a MultiItemStore, one AddItem per item as
+// before Batch existed, against one Commit of a Batch holding all of them.  Timed from
+// the first add until every item is visible.  Each store applies on a fiber of this
+// thread.
+//
+//   ItemStoreBatchBench [items] [rounds]
+
+using namespace ndtech;
+using namespace ndtech::bench;
+
+using NamedStore = NamedItemStore<int, std::string, ShardedItemMap>;
+using MultiStore = MultiItemStore<uint32_t, float, uint32_t>;
+
+std::vector<std::string> MakeNames(size_t itemCount) {
+  std::vector<std::string> names;
+  names.reserve(itemCount);
+  for (size_t index = 0; index < itemCount; index++) {
+    names.push_back("item" + std::to_string(index));
+  }
+  return names;
+}
+
+double LoadNamed(const std::vector<std::string>& names, bool batched) {
+  NamedStore store;
+  boost::fibers::fiber fiber;
+  store.RunOn(fiber);
+
+  auto start = Clock::now();
+  uint64_t version = 0;
+  if (batched) {
+    NamedStore::Batch batch;
+    batch.m_itemActions.reserve(names.size());
+    for (size_t index = 0; index < names.size(); index++) {
+      batch.AddItem(names[index], static_cast<int>(index));
+    }
+    version = store.Commit(std::move(batch));
+  }
+  else {
+    for (size_t index = 0; index < names.size(); index++) {
+      version = store.AddItem(names[index], static_cast<int>(index));
+    }
+  }
+  store.WaitForVersion(version);
+  double milliseconds = MillisecondsSince(start);
+
+  store.Stop();
+  fiber.join();
+  return milliseconds;
+}
+
+double LoadMulti(size_t itemCount, bool batched) {
+  MultiStore store;
+  boost::fibers::fiber fiber;
+  store.RunOn(fiber);
+
+  auto start = Clock::now();
+  if (batched) {
+    MultiStore::Batch batch;
+    batch.m_itemActions.reserve(itemCount);
+    for (size_t index = 0; index < itemCount; index++) {
+      batch.AddItem(static_cast<uint32_t>(index), 1.0f, static_cast<uint32_t>(index));
+    }
+    store.Commit(std::move(batch));
+  }
+  else {
+    for (size_t index = 0; index < itemCount; index++) {
+      store.AddItem(static_cast<uint32_t>(index), 1.0f, static_cast<uint32_t>(index));
+    }
+  }
+  while (store.Size() != itemCount) {
+    boost::this_fiber::yield();
+  }
+  double milliseconds = MillisecondsSince(start);
+
+  store.Stop();
+  fiber.join();
+  return milliseconds;
+}
+
+template <typename LoadType>
+void Measure(const char* name, size_t rounds, LoadType&& load) {
+  std::vector<double> samples;
+  for (size_t round = 0; round < rounds; round++) {
+    samples.push_back(load());
+  }
+  double median = Percentile(samples, 50.0);
+  std::printf("%-36s p50 %7.2f ms   best %7.2f ms\n", name, median, samples.front());
+}
+
+int main(int argc, char** argv) {
+  size_t itemCount = SizeArgument(argc, argv, 1, 100000);
+  size_t rounds = SizeArgument(argc, argv, 2, 9);
+
+  std::vector<std::string> names = MakeNames(itemCount);
+
+  std::printf("%zu items, %zu rounds\n", itemCount, rounds);
+  Measure("NamedItemStore, AddItem per item", rounds, [&]() { return LoadNamed(names, false); });
+  Measure("NamedItemStore, one Batch", rounds, [&]() { return LoadNamed(names, true); });
+  Measure("MultiItemStore, AddItem per item", rounds, [&]() { return LoadMulti(itemCount, false); });
+  Measure("MultiItemStore, one Batch", rounds, [&]() { return LoadMulti(itemCount, true); });
+
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#include "NamedItemStore.h"
+#include "BenchUtilities.h"
+
+#include <random>
+#include <string>
+#include <thread>
+
+// Lookup throughput of NamedItemStore::TryGetItem with 1 to 32 reader threads, for each
+// backend, over file-path keys like the ones m_fileDataStore holds
+//
+//   ItemStoreReadBench [items] [millisecondsPerPoint] [maxReaders]
+
+using namespace ndtech;
+using namespace ndtech::bench;
+
+std::vector<std::wstring> MakeNames(size_t itemCount) {
+  std::vector<std::wstring> names;
+  names.reserve(itemCount);
+  for (size_t index = 0; index < itemCount; index++) {
+    names.push_back(L"/package/content/shaders/material" + std::to_wstring(index % 97) + L"/pass" + std::to_wstring(index) + L".glsl");
+  }
+  return names;
+}
+
+template <template <typename, typename> class ItemMapType>
+void MeasureBackend(const char* backendName, const std::vector<std::wstring>& names, size_t milliseconds, size_t maxReaders) {
+  using Store = NamedItemStore<int, std::wstring, ItemMapType>;
+
+  Store store;
+  std::thread storeThread(&Store::Run, &store);
+
+  typename Store::Batch batch;
+  for (size_t index = 0; index < names.size(); index++) {
+    batch.AddItem(names[index], static_cast<int>(index));
+  }
+  store.WaitForVersion(store.Commit(std::move(batch)));
+
+  std::printf("%-16s", backendName);
+  for (size_t readerCount = 1; readerCount <= maxReaders; readerCount *= 2) {
+    std::atomic<bool> running{ true };
+    std::atomic<uint64_t> lookups{ 0 };
+    std::vector<std::thread> readers;
+
+    for (size_t reader = 0; reader < readerCount; reader++) {
+      readers.emplace_back([&, reader]() {
+        std::mt19937 random(static_cast<uint32_t>(reader));
+        uint64_t readerLookups = 0;
+        uint64_t found = 0;
+        while (running.load(std::memory_order_relaxed)) {
+          found += store.TryGetItem(names[random() % names.size()]) != nullptr;
+          readerLookups++;
+        }
+        if (found != readerLookups) {
+          std::printf("\nmissing items\n");
+          std::exit(1);
+        }
+        lookups += readerLookups;
+      });
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+    running = false;
+    for (std::thread& thread : readers) {
+      thread.join();
+    }
+
+    std::printf(" %8.2f", lookups.load() / (milliseconds * 1000.0));
+  }
+  std::printf("   M lookups/s\n");
+
+  store.Stop();
+  storeThread.join();
+}
+
+int main(int argc, char** argv) {
+  size_t itemCount = SizeArgument(argc, argv, 1, 10000);
+  size_t milliseconds = SizeArgument(argc, argv, 2, 250);
+  size_t maxReaders = SizeArgument(argc, argv, 3, 32);
+
+  std::vector<std::wstring> names = MakeNames(itemCount);
+
+  std::printf("%zu items, readers:", itemCount);
+  for (size_t readerCount = 1; readerCount <= maxReaders; readerCount *= 2) {
+    std::printf(" %8zu", readerCount);
+  }
+  std::printf("\n");
+
+  MeasureBackend<OrderedItemMap>("OrderedItemMap", names, milliseconds, maxReaders);
+  MeasureBackend<ShardedItemMap>("ShardedItemMap", names, milliseconds, maxReaders);
+  MeasureBackend<SnapshotItemMap>("SnapshotItemMap", names, milliseconds, maxReaders);
+
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,139 @@
+#include "MultiItemStore.h"
+#include "BenchUtilities.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+// Cost per applied action in MultiItemStore as the store grows, for adds, updates and
+// removes in random id order.  The same adds and removes are run for comparison through
+// the apply code the store had before its id index: a copy of the id column and a linear
+// search per action, and vector::erase on every column to remove.
+//
+//   MultiItemStoreBench [largestStore] [largestPreviousStore]
+
+using namespace ndtech;
+using namespace ndtech::bench;
+
+using Store = MultiItemStore<uint32_t, float, uint64_t>;
+
+std::vector<uint32_t> ShuffledIds(size_t count, uint64_t seed) {
+  std::vector<uint32_t> ids(count);
+  std::iota(ids.begin(), ids.end(), 0);
+  std::shuffle(ids.begin(), ids.end(), std::mt19937_64(seed));
+  return ids;
+}
+
+// The store applies on a fiber of this thread, so it runs whenever this fiber yields
+template <typename DoneType>
+void YieldUntil(DoneType&& done) {
+  while (!done()) {
+    boost::this_fiber::yield();
+  }
+}
+
+void MeasureStore(size_t itemCount) {
+  Store store;
+  boost::fibers::fiber fiber;
+  store.RunOn(fiber);
+
+  std::vector<uint32_t> ids = ShuffledIds(itemCount, itemCount);
+  uint32_t lastId = ids.back();
+
+  auto start = Clock::now();
+  for (uint32_t id : ids) {
+    store.AddItem(id, 1.0f, id);
+  }
+  YieldUntil([&]() { return store.Size() == itemCount; });
+  double addMilliseconds = MillisecondsSince(start);
+
+  std::shuffle(ids.begin(), ids.end(), std::mt19937_64(1));
+  start = Clock::now();
+  for (uint32_t id : ids) {
+    store.AddItem(id, 2.0f, id);
+  }
+  YieldUntil([&]() { return std::get<0>(store.GetItem(lastId)) == 2.0f; });
+  double updateMilliseconds = MillisecondsSince(start);
+
+  std::shuffle(ids.begin(), ids.end(), std::mt19937_64(2));
+  size_t removeCount = itemCount / 2;
+  start = Clock::now();
+  for (size_t index = 0; index < removeCount; index++) {
+    store.RemoveItem(ids[index]);
+  }
+  YieldUntil([&]() { return store.Size() == itemCount - removeCount; });
+  double removeMilliseconds = MillisecondsSince(start);
+
+  store.Stop();
+  fiber.join();
+
+  std::printf("%8zu items   add %6.1f ns   update %6.1f ns   remove %6.1f ns   per action\n", itemCount,
+    addMilliseconds * 1e6 / itemCount, updateMilliseconds * 1e6 / itemCount, removeMilliseconds * 1e6 / removeCount);
+}
+
+// The apply loop as it was, without the store around it
+struct PreviousColumns {
+  std::tuple<std::vector<uint32_t>, std::vector<float>, std::vector<uint64_t>> m_items;
+
+  void Add(uint32_t id, float value, uint64_t payload) {
+    auto ids = std::get<0>(m_items);
+    auto foundId = std::find(ids.begin(), ids.end(), id);
+    if (foundId == ids.end()) {
+      std::get<0>(m_items).push_back(id);
+      std::get<1>(m_items).push_back(value);
+      std::get<2>(m_items).push_back(payload);
+    }
+    else {
+      size_t index = std::distance(ids.begin(), foundId);
+      std::get<1>(m_items).at(index) = value;
+      std::get<2>(m_items).at(index) = payload;
+    }
+  }
+
+  void Remove(uint32_t id) {
+    auto ids = std::get<0>(m_items);
+    auto foundId = std::find(ids.begin(), ids.end(), id);
+    if (foundId != ids.end()) {
+      size_t index = std::distance(ids.begin(), foundId);
+      std::get<0>(m_items).erase(std::get<0>(m_items).begin() + index);
+      std::get<1>(m_items).erase(std::get<1>(m_items).begin() + index);
+      std::get<2>(m_items).erase(std::get<2>(m_items).begin() + index);
+    }
+  }
+};
+
+void MeasurePrevious(size_t itemCount) {
+  PreviousColumns columns;
+  std::vector<uint32_t> ids = ShuffledIds(itemCount, itemCount);
+
+  auto start = Clock::now();
+  for (uint32_t id : ids) {
+    columns.Add(id, 1.0f, id);
+  }
+  double addMilliseconds = MillisecondsSince(start);
+
+  std::shuffle(ids.begin(), ids.end(), std::mt19937_64(2));
+  size_t removeCount = itemCount / 2;
+  start = Clock::now();
+  for (size_t index = 0; index < removeCount; index++) {
+    columns.Remove(ids[index]);
+  }
+  double removeMilliseconds = MillisecondsSince(start);
+
+  std::printf("%8zu items   add %6.0f ns   remove %6.0f ns   per action, previous apply\n", itemCount,
+    addMilliseconds * 1e6 / itemCount, removeMilliseconds * 1e6 / removeCount);
+}
+
+int main(int argc, char** argv) {
+  size_t largestStore = SizeArgument(argc, argv, 1, 1000000);
+  size_t largestPrevious = SizeArgument(argc, argv, 2, 40000);
+
+  for (size_t itemCount = largestStore / 100; itemCount <= largestStore; itemCount *= 10) {
+    MeasureStore(itemCount);
+  }
+  for (size_t itemCount = largestPrevious / 4; itemCount <= largestPrevious; itemCount *= 2) {
+    MeasurePrevious(itemCount);
+  }
+
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include "TaskQueue.h"
+#include "BenchUtilities.h"
+
+#include <random>
+
+// Compares the Scheduler's two timed queues: a burst of one-shot tasks through the
+// min-heap, and a population of repeating tasks run for a while through both the heap
+// and the timer wheel
+//
+//   TaskQueueBench [oneShotTasks] [repeatingTasks]
+
+using namespace ndtech;
+using namespace ndtech::bench;
+using namespace std::chrono;
+
+using Entry = TimedEntry<uint32_t, Clock::time_point>;
+
+template <typename QueueType>
+double RunOneShot(QueueType& queue, Clock::time_point origin, size_t taskCount) {
+  std::mt19937_64 random(1);
+  std::vector<Entry> ready;
+  ready.reserve(taskCount);
+
+  auto start = Clock::now();
+  for (size_t index = 0; index < taskCount; index++) {
+    queue.Push(Entry{ static_cast<uint32_t>(index), origin + microseconds(random() % 1000000), index });
+  }
+  // Drain in 1 ms steps, as the scheduler thread would
+  for (auto now = origin; ready.size() < taskCount; now += 1ms) {
+    queue.PopReady(now, ready);
+  }
+  return MillisecondsSince(start);
+}
+
+// Every task repeats at one of a handful of intervals for simulatedSeconds
+template <typename QueueType>
+double RunRepeating(QueueType& queue, Clock::time_point origin, size_t taskCount, size_t& runs) {
+  static const microseconds intervals[] = { 1000us, 5000us, 16667us, 100000us, 1000000us };
+  const auto simulatedTime = 10s;
+
+  for (size_t index = 0; index < taskCount; index++) {
+    queue.Push(Entry{ static_cast<uint32_t>(index), origin + intervals[index % 5], index });
+  }
+
+  std::vector<Entry> ready;
+  uint64_t sequence = taskCount;
+  runs = 0;
+
+  auto start = Clock::now();
+  for (auto now = origin; now < origin + simulatedTime; now += 1ms) {
+    ready.clear();
+    queue.PopReady(now, ready);
+    runs += ready.size();
+    for (Entry& entry : ready) {
+      entry.m_time += intervals[entry.m_payload % 5];
+      entry.m_sequence = sequence++;
+      queue.Push(entry);
+    }
+  }
+  return MillisecondsSince(start);
+}
+
+int main(int argc, char** argv) {
+  size_t oneShotTasks = SizeArgument(argc, argv, 1, 1000000);
+  size_t repeatingTasks = SizeArgument(argc, argv, 2, 10000);
+
+  auto origin = Clock::now();
+
+  {
+    TaskHeap<Entry> heap;
+    double heapTime = RunOneShot(heap, origin, oneShotTasks);
+
+    TimerWheel<Entry> wheel(origin, 1000us);
+    double wheelTime = RunOneShot(wheel, origin, oneShotTasks);
+
+    std::printf("%zu one-shot tasks over 1 s:   heap %8.1f ms   wheel %8.1f ms\n", oneShotTasks, heapTime, wheelTime);
+  }
+
+  {
+    size_t heapRuns = 0;
+    TaskHeap<Entry> heap;
+    double heapTime = RunRepeating(heap, origin, repeatingTasks, heapRuns);
+
+    size_t wheelRuns = 0;
+    TimerWheel<Entry> wheel(origin, 1000us);
+    double wheelTime = RunRepeating(wheel, origin, repeatingTasks, wheelRuns);
+
+    std::printf("%zu repeating tasks for 10 s: heap %8.1f ms   wheel %8.1f ms   (%zu runs)\n", repeatingTasks, heapTime, wheelTime, heapRuns);
+    if (heapRuns != wheelRuns) {
+      std::printf("heap and wheel disagree on the number of runs: %zu and %zu\n", heapRuns, wheelRuns);
+      return 1;
+    }
+  }
+
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,109 @@
+#include "Scheduler.h"
+#include "SchedulerTrace.h"
+#include "BenchUtilities.h"
+
+// What a trace point costs a task with the trace points compiled in, against the < 5 ns
+// per task target while tracing is disabled.  Runs the same tasks with no trace point,
+// and inside NDTECH_TRACE_TASK with tracing disabled and enabled.  Then runs PerFrame
+// lane tasks through Scheduler::RunFrameTasks, whose trace point is the one every lane
+// task goes through, with tracing disabled and enabled.
+//
+//   TraceOverheadBench [tasks] [rounds]
+
+using namespace ndtech;
+using namespace ndtech::bench;
+
+static_assert(NDTECH_SCHEDULER_TRACING, "TraceOverheadBench must link ndtech_headless_traced");
+
+enum class TracePoint {
+  None,
+  Disabled,
+  Enabled
+};
+
+double NanosecondsPerTask(std::vector<Task>& tasks, TracePoint tracePoint) {
+  Tracer::Enable(tracePoint == TracePoint::Enabled);
+  Tracer::Clock::time_point queued = Tracer::Clock::now();
+
+  Clock::time_point start = Clock::now();
+  if (tracePoint == TracePoint::None) {
+    for (Task& task : tasks) {
+      task();
+    }
+  }
+  else {
+    for (Task& task : tasks) {
+      NDTECH_TRACE_TASK("Bench task", queued);
+      task();
+    }
+  }
+  double nanoseconds = MillisecondsSince(start) * 1000000.0 / tasks.size();
+
+  Tracer::Enable(false);
+  return nanoseconds;
+}
+
+double NanosecondsPerFrameTask(Scheduler& scheduler, size_t taskCount, std::atomic<size_t>& runs, bool enabled) {
+  for (size_t index = 0; index < taskCount; index++) {
+    scheduler.AddTask([&runs]() { runs.fetch_add(1, std::memory_order_relaxed); }, TaskLane::PerFrame);
+  }
+
+  Tracer::Enable(enabled);
+  Clock::time_point start = Clock::now();
+  scheduler.RunFrameTasks(3600s);
+  double nanoseconds = MillisecondsSince(start) * 1000000.0 / taskCount;
+  Tracer::Enable(false);
+
+  return nanoseconds;
+}
+
+int main(int argc, char** argv) {
+  size_t taskCount = SizeArgument(argc, argv, 1, 1000000);
+  size_t rounds = SizeArgument(argc, argv, 2, 21);
+
+  std::atomic<size_t> runs{ 0 };
+  std::vector<Task> tasks;
+  tasks.reserve(taskCount);
+  for (size_t index = 0; index < taskCount; index++) {
+    tasks.emplace_back([&runs]() { runs.fetch_add(1, std::memory_order_relaxed); });
+  }
+
+  // Interleaved, so drift in the machine's speed affects every mode alike
+  std::vector<double> none;
+  std::vector<double> disabled;
+  std::vector<double> enabled;
+  for (size_t round = 0; round < rounds; round++) {
+    none.push_back(NanosecondsPerTask(tasks, TracePoint::None));
+    disabled.push_back(NanosecondsPerTask(tasks, TracePoint::Disabled));
+    enabled.push_back(NanosecondsPerTask(tasks, TracePoint::Enabled));
+    Tracer::Clear();
+  }
+
+  double noneMedian = Percentile(none, 50.0);
+  double disabledMedian = Percentile(disabled, 50.0);
+  double enabledMedian = Percentile(enabled, 50.0);
+
+  std::printf("%zu tasks, %zu rounds, p50 per task\n", taskCount, rounds);
+  std::printf("no trace point                 %7.2f ns\n", noneMedian);
+  std::printf("trace point, tracing disabled  %7.2f ns   %+6.2f ns\n", disabledMedian, disabledMedian - noneMedian);
+  std::printf("trace point, tracing enabled   %7.2f ns   %+6.2f ns\n", enabledMedian, enabledMedian - noneMedian);
+
+  Scheduler scheduler;
+  std::vector<double> frameDisabled;
+  std::vector<double> frameEnabled;
+  for (size_t round = 0; round < rounds; round++) {
+    frameDisabled.push_back(NanosecondsPerFrameTask(scheduler, taskCount, runs, false));
+    frameEnabled.push_back(NanosecondsPerFrameTask(scheduler, taskCount, runs, true));
+    Tracer::Clear();
+  }
+  scheduler.Join();
+
+  double frameDisabledMedian = Percentile(frameDisabled, 50.0);
+  double frameEnabledMedian = Percentile(frameEnabled, 50.0);
+  std::printf("RunFrameTasks, tracing disabled %7.2f ns\n", frameDisabledMedian);
+  std::printf("RunFrameTasks, tracing enabled  %7.2f ns\n", frameEnabledMedian);
+
+  std::printf("disabled trace point under 5 ns per task: %s\n", disabledMedian - noneMedian < 5.0 ? "yes" : "no");
+
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include "Scheduler.h"
+#include "BenchUtilities.h"
+
+#include <condition_variable>
+#include <mutex>
+
+// Schedules one task at a time 1 ms out and measures how late it starts, against the
+// p99 < 100 us target for the spin-then-park wakeup.  Also prints the Scheduler's own
+// wake lateness percentiles from GetStats.
+//
+//   WakeLatencyBench [tasks] [spinMicroseconds]
+
+using namespace ndtech;
+using namespace ndtech::bench;
+
+int main(int argc, char** argv) {
+  size_t taskCount = SizeArgument(argc, argv, 1, 5000);
+
+  SchedulerSettings settings;
+  settings.m_wakeSpin = microseconds(SizeArgument(argc, argv, 2, 100));
+  Scheduler scheduler(settings);
+
+  std::vector<int64_t> lateness;
+  lateness.reserve(taskCount);
+
+  std::mutex doneMutex;
+  std::condition_variable doneConditionVariable;
+
+  for (size_t index = 0; index < taskCount; index++) {
+    bool done = false;
+    Scheduler::TimePoint due = Scheduler::Clock::now() + 1ms;
+
+    scheduler.AddTask(std::make_pair(Task([&, due]() {
+      int64_t late = std::chrono::duration_cast<nanoseconds>(Scheduler::Clock::now() - due).count();
+      std::lock_guard<std::mutex> guard(doneMutex);
+      lateness.push_back(late);
+      done = true;
+      doneConditionVariable.notify_all();
+    }), due));
+
+    std::unique_lock<std::mutex> lock(doneMutex);
+    doneConditionVariable.wait(lock, [&done]() { return done; });
+  }
+
+  SchedulerStats stats = scheduler.GetStats();
+  scheduler.Join();
+
+  int64_t p50 = Percentile(lateness, 50.0);
+  int64_t p99 = Percentile(lateness, 99.0);
+  int64_t p999 = Percentile(lateness, 99.9);
+
+  std::printf("%zu tasks 1 ms out, spin %lld us\n", taskCount, static_cast<long long>(settings.m_wakeSpin.count()));
+  std::printf("task start lateness:    p50 %7.1f us   p99 %7.1f us   p99.9 %7.1f us\n", p50 / 1000.0, p99 / 1000.0, p999 / 1000.0);
+  std::printf("scheduler wake lateness: p50 %7.1f us   p99 %7.1f us   p99.9 %7.1f us   (%llu wakes)\n",
+    stats.m_wakeLateness.m_p50Nanoseconds / 1000.0,
+    stats.m_wakeLateness.m_p99Nanoseconds / 1000.0,
+    stats.m_wakeLateness.m_p999Nanoseconds / 1000.0,
+    static_cast<unsigned long long>(stats.m_wakeLateness.m_samples));
+  std::printf("p99 under 100 us: %s\n", p99 < 100000 ? "yes" : "no");
+
+  return 0;
+}
\ No newline at end of file
@@ -95,12 +95,34 @@ TRACELOGGING_DECLARE_PROVIDER(traceProvider);
 #include <chrono>
 #include <cmath>
 
+#if NDTECH_HEADLESS
+// The headless build only has the scheduler, stores and App core, for the tests and
+// benchmarks, so it goes without g3log and glm and logs to std::clog
+#include <iostream>
+
+using byte = unsigned char;
+
+namespace ndtech {
+  struct HeadlessLogLine {
+    ~HeadlessLogLine() { std::clog << std::endl; }
+
+    template <typename ValueType>
+    HeadlessLogLine& operator<<(const ValueType& value) {
+      std::clog << value;
+      return *this;
+    }
+  };
+}
+
+#define LOG(level) ::ndtech::HeadlessLogLine{} << #level ": "
+#else
 #include <g3log/g3log.hpp>
 
 #include <runtime/external/glm/glm/glm.hpp>
 #include <runtime/external/glm/glm/gtx/quaternion.hpp>
 #include <runtime/external/glm/glm/gtx/transform.hpp>
 #include <runtime/external/glm/glm/gtc/type_ptr.hpp>
+#endif
 
 #define NDTECH_CORE_FWD(...) ::std::forward<decltype(__VA_ARGS__)>(__VA_ARGS__)
 #define NDTECH_FWD(...) NDTECH_CORE_FWD(__VA_ARGS__)
\ No newline at end of file
@@ -0,0 +1,181 @@
+#include "ApplicationSettings.h"
+#include "App.h"
+#include "TestCheck.h"
+
+#include <random>
+#include <stdexcept>
+
+using namespace ndtech;
+
+struct Counter {
+  uint32_t m_updates = 0;
+};
+
+struct Flag {
+  bool m_throw = false;
+};
+
+struct CounterSystem {
+  using Component = Counter;
+  using Writes = TypeUtilities::Typelist<Counter>;
+  static constexpr bool ParallelSafe = true;
+
+  void UpdateComponent(Counter* counter, BaseApp*) {
+    counter->m_updates++;
+  }
+};
+
+struct FlagSystem {
+  using Component = Flag;
+  using Reads = TypeUtilities::Typelist<Flag>;
+  static constexpr bool ParallelSafe = true;
+
+  void UpdateComponent(Flag* flag, BaseApp*) {
+    if (flag->m_throw) {
+      throw std::runtime_error("flag");
+    }
+  }
+};
+
+using TestSettings = ApplicationSettings<TypeUtilities::Typelist<Counter, Flag>, TypeUtilities::Typelist<CounterSystem, FlagSystem>>;
+
+struct TestApp : App<TestSettings, TestApp> {
+  explicit TestApp(SchedulerSettings schedulerSettings)
+    : App<TestSettings, TestApp>(schedulerSettings) {
+  }
+};
+
+static_assert(TestApp::Schedule::PhaseCount == 1, "CounterSystem and FlagSystem touch different components");
+
+// A system that reads what another writes goes in the next phase, one that declares
+// nothing conflicts with both
+struct CounterReader {
+  using Reads = TypeUtilities::Typelist<Counter>;
+};
+
+struct Undeclared {
+};
+
+using OrderedSchedule = SystemSchedule<TypeUtilities::Typelist<Counter, Flag>, TypeUtilities::Typelist<CounterSystem, FlagSystem, CounterReader, Undeclared>, TypeUtilities::Typelist<>>;
+static_assert(OrderedSchedule::PhaseCount == 3, "CounterReader after CounterSystem, Undeclared after both");
+static_assert(OrderedSchedule::Phases[1] == 0 && OrderedSchedule::Phases[2] == 1 && OrderedSchedule::Phases[3] == 2, "phases follow declarations");
+
+// Every component of a ParallelSafe system is updated once per frame, however the range is
+// split into chunks and whatever the scheduler has to spread them over
+void UpdatesEveryComponentOnce(SchedulerMode mode) {
+  SchedulerSettings schedulerSettings;
+  schedulerSettings.m_mode = mode;
+  schedulerSettings.m_workerCount = 4;
+  TestApp app(schedulerSettings);
+  app.Initialize();
+
+  const size_t entityCount = 100003;
+  for (size_t entity = 0; entity < entityCount; entity++) {
+    auto& added = app.AddEntity();
+    app.AddComponent(added, Counter{});
+    if (entity % 3 == 0) {
+      app.AddComponent(added, Flag{});
+    }
+  }
+
+  for (uint32_t frame = 1; frame <= 3; frame++) {
+    app.UpdateComponentSystems(TestApp::ComponentSystems{});
+
+    size_t visited = 0;
+    app.View<Counter>([&](auto&, Counter& counter) {
+      NDTECH_CHECK(counter.m_updates == frame);
+      visited++;
+    });
+    NDTECH_CHECK(visited == entityCount);
+  }
+
+  // A throwing system fails the frame rather than the process
+  auto& thrower = app.AddEntity();
+  app.AddComponent(thrower, Flag{ true });
+  bool caught = false;
+  try {
+    app.UpdateComponentSystems(TestApp::ComponentSystems{});
+  }
+  catch (const std::runtime_error&) {
+    caught = true;
+  }
+  NDTECH_CHECK(caught);
+
+  app.m_scheduler.Join();
+}
+
+// Removed slots are reused under churn, so the entity storage stops growing, and a handle
+// to a removed entity never reaches whatever reuses its slot
+void ReusesRemovedEntitySlots() {
+  TestApp app(SchedulerSettings{});
+  app.Initialize();
+
+  std::vector<TestApp::EntityHandle> live;
+  for (int entity = 0; entity < 1000; entity++) {
+    auto& added = app.AddEntity();
+    app.AddComponent(added, Counter{ static_cast<uint32_t>(entity) });
+    live.push_back(app.GetHandle(added));
+  }
+  size_t slots = app.m_freeEntityIndex;
+
+  std::mt19937 random(3);
+  for (int operation = 0; operation < 100000; operation++) {
+    size_t victim = random() % live.size();
+    TestApp::EntityHandle removed = live[victim];
+    NDTECH_CHECK(app.RemoveEntity(removed));
+    NDTECH_CHECK(!app.IsAlive(removed));
+    NDTECH_CHECK(!app.RemoveEntity(removed));
+
+    auto& added = app.AddEntity();
+    app.AddComponent(added, Counter{ static_cast<uint32_t>(operation) });
+    TestApp::EntityHandle handle = app.GetHandle(added);
+    NDTECH_CHECK(handle.index == removed.index && handle.generation == removed.generation + 1);
+    NDTECH_CHECK(app.GetEntity(removed) == nullptr);
+    NDTECH_CHECK(app.GetComponent<Counter>(removed) == nullptr);
+    NDTECH_CHECK(app.GetComponent<Counter>(handle)->m_updates == static_cast<uint32_t>(operation));
+    live[victim] = handle;
+  }
+
+  NDTECH_CHECK(app.m_freeEntityIndex == slots);
+  size_t counters = 0;
+  app.View<Counter>([&](auto&, Counter&) { counters++; });
+  NDTECH_CHECK(counters == live.size());
+
+  app.m_scheduler.Join();
+}
+
+// Adding through a handle whose entity is gone adds nothing, not even to the entity that
+// has since taken its slot
+void RejectsStaleHandlesInAddComponent() {
+  TestApp app(SchedulerSettings{});
+  app.Initialize();
+
+  TestApp::EntityHandle removed = app.GetHandle(app.AddEntity());
+  Counter* counter = app.AddComponent(removed, Counter{ 1 });
+  NDTECH_CHECK(counter != nullptr && counter == app.GetComponent<Counter>(removed));
+  NDTECH_CHECK(app.RemoveEntity(removed));
+
+  TestApp::EntityHandle reused = app.GetHandle(app.AddEntity());
+  NDTECH_CHECK(reused.index == removed.index);
+  NDTECH_CHECK(app.AddComponent(removed, Counter{ 2 }) == nullptr);
+  NDTECH_CHECK(app.AddComponent(removed, Flag{}) == nullptr);
+  NDTECH_CHECK(!app.HasComponent<Counter>(reused));
+  NDTECH_CHECK(!app.HasComponent<Flag>(reused));
+
+  NDTECH_CHECK(app.AddComponent(reused, Counter{ 3 })->m_updates == 3);
+  NDTECH_CHECK(app.AddComponent(reused, Counter{ 4 })->m_updates == 4);
+  size_t counters = 0;
+  app.View<Counter>([&](auto&, Counter&) { counters++; });
+  NDTECH_CHECK(counters == 1);
+
+  app.m_scheduler.Join();
+}
+
+int main() {
+  RejectsStaleHandlesInAddComponent();
+  ReusesRemovedEntitySlots();
+  UpdatesEveryComponentOnce(SchedulerMode::SingleThread);
+  UpdatesEveryComponentOnce(SchedulerMode::WorkStealing);
+  UpdatesEveryComponentOnce(SchedulerMode::Fibers);
+  return 0;
+}
\ No newline at end of file
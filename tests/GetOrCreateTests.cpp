@@ -0,0 +1,187 @@
+#include "NamedItemStore.h"
+#include "TestCheck.h"
+
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace ndtech;
+
+const int ThreadCount = 4;
+const int FibersPerThread = 4;
+const int NameCount = 50;
+
+// Callers on several threads, each running several fibers, ask for the same names at
+// once.  Each factory runs once per name and every caller gets the item it made.
+template <template <typename, typename> class ItemMapType>
+void FactoryRunsOncePerName() {
+  using Store = NamedItemStore<std::string, int, ItemMapType>;
+
+  Store store;
+  std::thread storeThread([&store]() { store.Run(); });
+
+  std::vector<std::atomic<int>> factoryCalls(NameCount);
+  std::vector<std::vector<const std::string*>> results(ThreadCount * FibersPerThread, std::vector<const std::string*>(NameCount));
+
+  std::atomic<bool> start{ false };
+  std::vector<std::thread> threads;
+  for (int thread = 0; thread < ThreadCount; thread++) {
+    threads.emplace_back([&, thread]() {
+      while (!start) {
+        std::this_thread::yield();
+      }
+
+      std::vector<boost::fibers::fiber> fibers;
+      for (int fiber = 0; fiber < FibersPerThread; fiber++) {
+        fibers.emplace_back([&, caller = thread * FibersPerThread + fiber]() {
+          for (int step = 0; step < NameCount; step++) {
+            // Callers start at different names, so some find the item made, some wait on
+            // a factory and some run it
+            int name = (step + caller) % NameCount;
+            typename Store::ItemPointer item = store.GetOrCreate(name, [&factoryCalls, name]() {
+              factoryCalls[name]++;
+              // Long enough for the other callers to arrive while it runs
+              boost::this_fiber::sleep_for(std::chrono::milliseconds(1));
+              return std::to_string(name);
+            });
+            NDTECH_CHECK(item != nullptr && *item == std::to_string(name));
+            results[caller][name] = item.get();
+          }
+        });
+      }
+      for (boost::fibers::fiber& fiber : fibers) {
+        fiber.join();
+      }
+    });
+  }
+
+  start = true;
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  for (int name = 0; name < NameCount; name++) {
+    NDTECH_CHECK(factoryCalls[name] == 1);
+    for (auto& callerResults : results) {
+      NDTECH_CHECK(callerResults[name] == results[0][name]);
+    }
+  }
+
+  // Once applied, the store hands out the same item
+  for (int name = 0; name < NameCount; name++) {
+    NDTECH_CHECK(store.GetItemFor(name, std::chrono::seconds(10)).get() == results[0][name]);
+  }
+
+  store.Stop();
+  storeThread.join();
+}
+
+// GetItemFor gives up after its timeout, and returns an item added while it waits
+void GetItemForTimesOut() {
+  using Store = NamedItemStore<std::string, int, ShardedItemMap>;
+
+  Store store;
+  std::thread storeThread([&store]() { store.Run(); });
+
+  auto start = std::chrono::steady_clock::now();
+  NDTECH_CHECK(store.GetItemFor(1, std::chrono::milliseconds(30)) == nullptr);
+  auto waited = std::chrono::steady_clock::now() - start;
+  NDTECH_CHECK(waited >= std::chrono::milliseconds(30));
+  NDTECH_CHECK(waited < std::chrono::seconds(5));
+
+  std::thread adder([&store]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    store.AddItem(2, "late");
+  });
+  start = std::chrono::steady_clock::now();
+  typename Store::ItemPointer item = store.GetItemFor(2, std::chrono::seconds(10));
+  NDTECH_CHECK(item != nullptr && *item == "late");
+  NDTECH_CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+  adder.join();
+
+  store.Stop();
+  storeThread.join();
+}
+
+// A factory that throws hands the exception to its own caller only.  A caller that was
+// waiting on it runs its own factory, and later callers get that one's item.
+void RetriesAfterFactoryThrows() {
+  using Store = NamedItemStore<std::string, int, ShardedItemMap>;
+
+  Store store;
+  std::thread storeThread([&store]() { store.Run(); });
+
+  std::atomic<bool> firstFactoryRunning{ false };
+  std::atomic<bool> releaseFirstFactory{ false };
+  std::atomic<bool> thrown{ false };
+  std::atomic<bool> firstCallerCaught{ false };
+  std::thread firstCaller([&]() {
+    try {
+      store.GetOrCreate(1, [&]() -> std::string {
+        firstFactoryRunning = true;
+        while (!releaseFirstFactory) {
+          std::this_thread::yield();
+        }
+        thrown = true;
+        throw std::runtime_error("factory failed");
+      });
+    }
+    catch (const std::runtime_error&) {
+      firstCallerCaught = true;
+    }
+  });
+  while (!firstFactoryRunning) {
+    std::this_thread::yield();
+  }
+
+  std::atomic<int> secondFactoryCalls{ 0 };
+  typename Store::ItemPointer secondItem;
+  std::thread secondCaller([&]() {
+    secondItem = store.GetOrCreate(1, [&]() {
+      // Only once the first factory has failed
+      NDTECH_CHECK(thrown);
+      secondFactoryCalls++;
+      return std::string("second");
+    });
+  });
+
+  // Let the second caller reach the wait on the first factory
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  NDTECH_CHECK(secondFactoryCalls == 0);
+  releaseFirstFactory = true;
+
+  firstCaller.join();
+  secondCaller.join();
+  NDTECH_CHECK(firstCallerCaught);
+  NDTECH_CHECK(secondFactoryCalls == 1);
+  NDTECH_CHECK(secondItem != nullptr && *secondItem == "second");
+
+  typename Store::ItemPointer thirdItem = store.GetOrCreate(1, []() -> std::string {
+    NDTECH_CHECK(false);
+    return std::string();
+  });
+  NDTECH_CHECK(thirdItem.get() == secondItem.get());
+
+  // With nobody waiting, the next caller after a throw simply runs its factory
+  bool caught = false;
+  try {
+    store.GetOrCreate(2, []() -> std::string { throw std::runtime_error("factory failed"); });
+  }
+  catch (const std::runtime_error&) {
+    caught = true;
+  }
+  NDTECH_CHECK(caught);
+  NDTECH_CHECK(*store.GetOrCreate(2, []() { return std::string("retried"); }) == "retried");
+
+  store.Stop();
+  storeThread.join();
+}
+
+int main() {
+  FactoryRunsOncePerName<OrderedItemMap>();
+  FactoryRunsOncePerName<ShardedItemMap>();
+  FactoryRunsOncePerName<SnapshotItemMap>();
+  GetItemForTimesOut();
+  RetriesAfterFactoryThrows();
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include "NamedItemStore.h"
+#include "MultiItemStore.h"
+#include "TestCheck.h"
+
+#include <thread>
+
+using namespace ndtech;
+
+// Each batch rewrites every item to the batch's number.  Readers on other threads must
+// only ever see all the items from one batch, or none before the first, whatever the
+// backend, and each batch must be applied and published as one version.
+template <template <typename, typename> class ItemMapType>
+void NamedItemStoreBatchesApplyAtomically() {
+  using Store = NamedItemStore<int, int, ItemMapType>;
+
+  Store store;
+  boost::fibers::fiber fiber;
+  store.RunOn(fiber);
+
+  std::vector<int> names(100);
+  for (int name = 0; name < 100; name++) {
+    names[name] = name;
+  }
+
+  std::atomic<bool> stop{ false };
+  std::atomic<bool> torn{ false };
+  std::atomic<uint64_t> reads{ 0 };
+  std::vector<std::thread> readers;
+  for (int reader = 0; reader < 4; reader++) {
+    readers.emplace_back([&]() {
+      while (!stop) {
+        std::vector<typename Store::ItemPointer> items = store.TryGetItems(names);
+        if (items.front() == nullptr) {
+          for (auto& item : items) {
+            torn = torn || item != nullptr;
+          }
+        }
+        else {
+          for (auto& item : items) {
+            torn = torn || item == nullptr || *item != *items.front();
+          }
+        }
+        reads++;
+      }
+    });
+  }
+
+  uint64_t lastVersion = store.Version();
+  for (int batchNumber = 1; batchNumber <= 200; batchNumber++) {
+    typename Store::Batch batch;
+    for (int name : names) {
+      batch.AddItem(name, batchNumber);
+    }
+    uint64_t version = store.Commit(std::move(batch));
+    NDTECH_CHECK(version == lastVersion + 1);
+    store.WaitForVersion(version);
+    NDTECH_CHECK(store.Version() == version);
+    lastVersion = version;
+    std::this_thread::yield();
+  }
+
+  stop = true;
+  for (std::thread& reader : readers) {
+    reader.join();
+  }
+  NDTECH_CHECK(!torn);
+  NDTECH_CHECK(reads > 0);
+  NDTECH_CHECK(*store.TryGetItem(99) == 200);
+
+  store.Stop();
+  fiber.join();
+}
+
+// Readers of a MultiItemStore only see whole batches of 100 rows
+void MultiItemStoreBatchesApplyAtomically() {
+  MultiItemStore<uint32_t, uint32_t> store;
+  boost::fibers::fiber fiber;
+  store.RunOn(fiber);
+
+  bool stop = false;
+  bool torn = false;
+  boost::fibers::fiber reader([&]() {
+    while (!stop) {
+      torn = torn || store.Size() % 100 != 0;
+      boost::this_fiber::yield();
+    }
+  });
+
+  for (uint32_t batchNumber = 0; batchNumber < 50; batchNumber++) {
+    MultiItemStore<uint32_t, uint32_t>::Batch batch;
+    for (uint32_t row = 0; row < 100; row++) {
+      batch.AddItem(batchNumber * 100 + row, batchNumber);
+    }
+    store.Commit(std::move(batch));
+    boost::this_fiber::yield();
+  }
+  while (store.Size() != 5000) {
+    boost::this_fiber::yield();
+  }
+
+  stop = true;
+  reader.join();
+  NDTECH_CHECK(!torn);
+
+  store.Stop();
+  fiber.join();
+}
+
+int main() {
+  NamedItemStoreBatchesApplyAtomically<OrderedItemMap>();
+  NamedItemStoreBatchesApplyAtomically<ShardedItemMap>();
+  NamedItemStoreBatchesApplyAtomically<SnapshotItemMap>();
+  MultiItemStoreBatchesApplyAtomically();
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "NamedItemStore.h"
+#include "TestCheck.h"
+
+#include <string>
+#include <thread>
+
+using namespace ndtech;
+
+// Every backend may keep extra references to an entry, in shard copies or in snapshots
+// not yet reclaimed, so only items a reader still holds must survive eviction.  A slow
+// reader on another thread keeps every retired snapshot alive while the items go in.
+template <template <typename, typename> class ItemMapType>
+void EvictsOnlyUnheldItems() {
+  using Store = NamedItemStore<std::string, int, ItemMapType>;
+
+  Store store;
+  boost::fibers::fiber fiber;
+  store.RunOn(fiber);
+  store.SetByteBudget(10000, [](const std::string&) { return size_t{ 100 }; });
+
+  store.WaitForVersion(store.AddItem(0, "held"));
+  typename Store::ItemPointer held = store.TryGetItem(0);
+  NDTECH_CHECK(held != nullptr);
+
+  std::atomic<bool> reading{ false };
+  std::atomic<bool> doneAdding{ false };
+  std::thread slowReader([&]() {
+    EpochReclaimer::ReadGuard guard;
+    reading = true;
+    while (!doneAdding) {
+      std::this_thread::yield();
+    }
+  });
+  while (!reading) {
+    std::this_thread::yield();
+  }
+
+  bool withinBudget = true;
+  for (int name = 1; name <= 400; name++) {
+    store.WaitForVersion(store.AddItem(name, std::to_string(name)));
+    withinBudget = withinBudget && store.Stats().m_bytes <= 10000;
+  }
+
+  doneAdding = true;
+  slowReader.join();
+  NDTECH_CHECK(withinBudget);
+
+  NamedItemStoreStats stats = store.Stats();
+  NDTECH_CHECK(stats.m_evictions >= 300);
+  NDTECH_CHECK(stats.m_bytes <= 10000);
+  for (int name = 1; name <= 300; name++) {
+    NDTECH_CHECK(store.TryGetItem(name) == nullptr);
+  }
+  NDTECH_CHECK(store.TryGetItem(400) != nullptr);
+
+  typename Store::ItemPointer found = store.TryGetItem(0);
+  NDTECH_CHECK(found != nullptr && *found == "held");
+  NDTECH_CHECK(found.get() == held.get());
+
+  held = nullptr;
+  found = nullptr;
+  for (int name = 401; name <= 600; name++) {
+    store.WaitForVersion(store.AddItem(name, std::to_string(name)));
+  }
+  NDTECH_CHECK(store.TryGetItem(0) == nullptr);
+
+  store.Stop();
+  fiber.join();
+}
+
+int main() {
+  EvictsOnlyUnheldItems<OrderedItemMap>();
+  EvictsOnlyUnheldItems<ShardedItemMap>();
+  EvictsOnlyUnheldItems<SnapshotItemMap>();
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,114 @@
+#include "MultiItemStore.h"
+#include "TestCheck.h"
+
+#include <map>
+#include <random>
+
+using namespace ndtech;
+
+using Store = MultiItemStore<uint32_t, float, uint64_t>;
+
+// The store applies on a fiber of this thread, so it runs whenever this fiber yields
+template <typename DoneType>
+void YieldUntil(DoneType&& done) {
+  while (!done()) {
+    boost::this_fiber::yield();
+  }
+}
+
+// Random adds, updates and removes over a few hundred ids leave the same items as a
+// std::map given the same actions, with every row where the id index says it is
+void MatchesMapAfterRandomActions() {
+  Store store;
+  boost::fibers::fiber fiber;
+  store.RunOn(fiber);
+
+  std::map<uint32_t, std::pair<float, uint64_t>> expected;
+  std::mt19937 random(7);
+  for (uint64_t action = 0; action < 20000; action++) {
+    uint32_t id = random() % 300;
+    if (random() % 3 == 0) {
+      store.RemoveItem(id);
+      expected.erase(id);
+    }
+    else {
+      store.AddItem(id, static_cast<float>(action), action);
+      expected[id] = { static_cast<float>(action), action };
+    }
+
+    if (action % 1000 == 0) {
+      boost::this_fiber::yield();
+    }
+  }
+
+  store.AddItem(1000, 0.0f, 0);
+  YieldUntil([&]() { return store.ItemExists(1000); });
+  store.RemoveItem(1000);
+  YieldUntil([&]() { return !store.ItemExists(1000); });
+
+  NDTECH_CHECK(store.Size() == expected.size());
+  for (uint32_t id = 0; id < 300; id++) {
+    NDTECH_CHECK(store.ItemExists(id) == (expected.count(id) == 1));
+  }
+  for (auto& item : expected) {
+    std::tuple<float, uint64_t> stored = store.GetItem(item.first);
+    NDTECH_CHECK(std::get<0>(stored) == item.second.first);
+    NDTECH_CHECK(std::get<1>(stored) == item.second.second);
+  }
+
+  {
+    auto view = store.View<uint32_t, uint64_t>();
+    NDTECH_CHECK(view.Size() == expected.size());
+    for (size_t slot = 0; slot < view.Size(); slot++) {
+      uint32_t id = view.Get<uint32_t>()[slot];
+      NDTECH_CHECK(store.m_slots.at(id) == slot);
+      NDTECH_CHECK(view.Get<uint64_t>()[slot] == expected.at(id).second);
+    }
+  }
+
+  store.Stop();
+  fiber.join();
+}
+
+// Every column, of whatever element size, starts on a cache line however often it has grown
+void ColumnsAreAligned() {
+  MultiItemStore<uint32_t, float, uint8_t, double> store;
+  boost::fibers::fiber fiber;
+  store.RunOn(fiber);
+
+  for (uint32_t id = 1; id <= 5000; id++) {
+    store.AddItem(id, static_cast<float>(id), static_cast<uint8_t>(id), static_cast<double>(id));
+    if (id % 777 == 0) {
+      YieldUntil([&]() { return store.Size() == id; });
+
+      size_t columns = 0;
+      store.ForEachColumn([&](auto column) {
+        NDTECH_CHECK(column.size() == id);
+        NDTECH_CHECK(reinterpret_cast<uintptr_t>(column.data()) % decltype(store)::ColumnAlignment == 0);
+        columns++;
+      });
+      NDTECH_CHECK(columns == 4);
+    }
+  }
+
+  YieldUntil([&]() { return store.Size() == 5000; });
+  {
+    auto view = store.View<double, float>();
+    NDTECH_CHECK(view.Get<0>().size() == 5000 && view.Get<1>().size() == 5000);
+    double sum = 0.0;
+    for (size_t slot = 0; slot < view.Size(); slot++) {
+      NDTECH_CHECK(view.Get<double>()[slot] == view.Get<float>()[slot]);
+      sum += view.Get<double>()[slot];
+    }
+    NDTECH_CHECK(sum == 5000.0 * 5001.0 / 2.0);
+  }
+
+  store.Stop();
+  fiber.join();
+}
+
+int main() {
+  MatchesMapAfterRandomActions();
+  ColumnsAreAligned();
+  return 0;
+}
\ No newline at end of file
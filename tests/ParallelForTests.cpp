@@ -0,0 +1,102 @@
+#include "ParallelFor.h"
+#include "TestCheck.h"
+
+#include <stdexcept>
+#include <vector>
+
+using namespace ndtech;
+
+// Every index is called exactly once.  With no workers every call is made inline.
+void CallsEveryIndexOnce(Scheduler& scheduler) {
+  NDTECH_CHECK(scheduler.WorkerCount() == 0 || scheduler.WorkerCount() == 4);
+
+  for (size_t count : { size_t{ 1 }, size_t{ 3 }, size_t{ 1000 }, size_t{ 100000 } }) {
+    std::vector<std::atomic<int>> calls(count);
+    std::atomic<size_t> otherThreadCalls{ 0 };
+    std::thread::id caller = std::this_thread::get_id();
+
+    ParallelFor(scheduler, count, [&](size_t index) {
+      calls[index]++;
+      if (std::this_thread::get_id() != caller) {
+        otherThreadCalls++;
+      }
+    });
+
+    for (std::atomic<int>& call : calls) {
+      NDTECH_CHECK(call == 1);
+    }
+    if (scheduler.WorkerCount() == 0) {
+      NDTECH_CHECK(otherThreadCalls == 0);
+    }
+  }
+}
+
+// A throwing call stops indices that have not started, and ParallelFor rethrows once the
+// calls in flight are done with the function and its captures
+void RethrowsTheFirstException(Scheduler& scheduler) {
+  for (int round = 0; round < 50; round++) {
+    const size_t count = 10000;
+    std::atomic<size_t> running{ 0 };
+    std::atomic<size_t> calls{ 0 };
+    bool caught = false;
+
+    try {
+      ParallelFor(scheduler, count, [&](size_t index) {
+        running++;
+        calls++;
+        if (index == 100) {
+          running--;
+          throw std::runtime_error("index 100");
+        }
+        std::this_thread::yield();
+        running--;
+      });
+    }
+    catch (const std::runtime_error& error) {
+      caught = std::string(error.what()) == "index 100";
+    }
+
+    NDTECH_CHECK(caught);
+    NDTECH_CHECK(running == 0);
+    NDTECH_CHECK(calls < count);
+  }
+
+  // Still usable afterwards
+  std::atomic<size_t> calls{ 0 };
+  ParallelFor(scheduler, 1000, [&](size_t) { calls++; });
+  NDTECH_CHECK(calls == 1000);
+}
+
+// From a task on the same scheduler, which may be one of the helpers' own threads
+void RunsFromATask(Scheduler& scheduler) {
+  std::atomic<size_t> calls{ 0 };
+  std::atomic<bool> done{ false };
+  scheduler.AddTask([&]() {
+    ParallelFor(scheduler, 1000, [&](size_t) { calls++; });
+    done = true;
+  });
+
+  auto deadline = steady_clock::now() + 30s;
+  while (!done) {
+    NDTECH_CHECK(steady_clock::now() < deadline);
+    std::this_thread::sleep_for(1ms);
+  }
+  NDTECH_CHECK(calls == 1000);
+}
+
+int main() {
+  for (SchedulerMode mode : { SchedulerMode::SingleThread, SchedulerMode::WorkStealing, SchedulerMode::Fibers }) {
+    SchedulerSettings settings;
+    settings.m_mode = mode;
+    settings.m_workerCount = 4;
+    Scheduler scheduler(settings);
+
+    CallsEveryIndexOnce(scheduler);
+    RethrowsTheFirstException(scheduler);
+    RunsFromATask(scheduler);
+
+    scheduler.Join();
+  }
+
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,199 @@
+#include "Scheduler.h"
+#include "TestCheck.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace ndtech;
+
+const size_t ProducerCount = 16;
+const size_t TasksPerProducer = 5000;
+
+void WaitFor(std::atomic<size_t>& counter, size_t target) {
+  auto deadline = steady_clock::now() + 30s;
+  while (counter.load() < target) {
+    NDTECH_CHECK(steady_clock::now() < deadline);
+    std::this_thread::sleep_for(1ms);
+  }
+}
+
+// Calls produce(producerIndex) on ProducerCount threads at once
+template <typename ProduceType>
+void Flood(ProduceType produce) {
+  std::atomic<bool> start{ false };
+  std::vector<std::thread> producers;
+  for (size_t producer = 0; producer < ProducerCount; producer++) {
+    producers.emplace_back([&start, &produce, producer]() {
+      while (!start.load()) {
+        std::this_thread::yield();
+      }
+      produce(producer);
+    });
+  }
+  start = true;
+  for (std::thread& thread : producers) {
+    thread.join();
+  }
+}
+
+// Every task is either rejected or runs, and the counter agrees
+void RejectUnderFlood() {
+  SchedulerSettings settings;
+  settings.m_mode = SchedulerMode::WorkStealing;
+  settings.m_workerCount = 4;
+  settings.m_maxQueuedTasks = 64;
+  settings.m_queueFullPolicy = QueueFullPolicy::Reject;
+  Scheduler scheduler(settings);
+
+  std::atomic<size_t> accepted{ 0 };
+  std::atomic<size_t> rejected{ 0 };
+  std::atomic<size_t> ran{ 0 };
+
+  Flood([&](size_t) {
+    for (size_t index = 0; index < TasksPerProducer; index++) {
+      TaskHandle handle = scheduler.AddTask([&ran]() { ran++; });
+      (handle.IsRejected() ? rejected : accepted)++;
+    }
+  });
+
+  WaitFor(ran, accepted);
+  NDTECH_CHECK(accepted + rejected == ProducerCount * TasksPerProducer);
+  NDTECH_CHECK(scheduler.GetStats().m_rejectedTasks == rejected);
+
+  scheduler.Join();
+  NDTECH_CHECK(ran == accepted);
+}
+
+// Producers wait rather than lose work, and nothing deadlocks
+void BlockUnderFlood() {
+  SchedulerSettings settings;
+  settings.m_mode = SchedulerMode::WorkStealing;
+  settings.m_workerCount = 4;
+  settings.m_maxQueuedTasks = 32;
+  settings.m_queueFullPolicy = QueueFullPolicy::Block;
+  Scheduler scheduler(settings);
+
+  std::atomic<size_t> ran{ 0 };
+
+  Flood([&](size_t) {
+    for (size_t index = 0; index < TasksPerProducer; index++) {
+      NDTECH_CHECK(!scheduler.AddTask([&ran]() { ran++; }).IsRejected());
+    }
+  });
+
+  WaitFor(ran, ProducerCount * TasksPerProducer);
+  NDTECH_CHECK(scheduler.GetStats().m_rejectedTasks == 0);
+  scheduler.Join();
+}
+
+// Each producer coalesces on its own tag, so its newest task always gets in
+void DropOldestUnderFlood() {
+  SchedulerSettings settings;
+  settings.m_mode = SchedulerMode::WorkStealing;
+  settings.m_workerCount = 4;
+  settings.m_maxQueuedTasks = 64;
+  settings.m_queueFullPolicy = QueueFullPolicy::DropOldest;
+  Scheduler scheduler(settings);
+
+  std::atomic<size_t> accepted{ 0 };
+  std::atomic<size_t> ran{ 0 };
+
+  Flood([&](size_t producer) {
+    for (size_t index = 0; index < TasksPerProducer; index++) {
+      if (!scheduler.AddTask([&ran]() { ran++; }, producer + 1).IsRejected()) {
+        accepted++;
+      }
+    }
+  });
+
+  SchedulerStats stats;
+  auto deadline = steady_clock::now() + 30s;
+  do {
+    NDTECH_CHECK(steady_clock::now() < deadline);
+    std::this_thread::sleep_for(1ms);
+    stats = scheduler.GetStats();
+  } while (ran + stats.m_coalescedTasks < accepted);
+
+  NDTECH_CHECK(accepted + stats.m_rejectedTasks == ProducerCount * TasksPerProducer);
+  scheduler.Join();
+  NDTECH_CHECK(ran + scheduler.GetStats().m_coalescedTasks == accepted);
+}
+
+// A task that is running no longer holds a place in the queue
+void RunningTasksDoNotCount() {
+  SchedulerSettings settings;
+  settings.m_mode = SchedulerMode::WorkStealing;
+  settings.m_workerCount = 1;
+  settings.m_maxQueuedTasks = 1;
+  settings.m_queueFullPolicy = QueueFullPolicy::Reject;
+  Scheduler scheduler(settings);
+
+  std::mutex gateMutex;
+  std::condition_variable gateConditionVariable;
+  bool started = false;
+  bool open = false;
+
+  scheduler.AddTask([&]() {
+    std::unique_lock<std::mutex> lock(gateMutex);
+    started = true;
+    gateConditionVariable.notify_all();
+    gateConditionVariable.wait(lock, [&]() { return open; });
+  });
+
+  {
+    std::unique_lock<std::mutex> lock(gateMutex);
+    gateConditionVariable.wait(lock, [&]() { return started; });
+  }
+
+  // The only worker is busy, so this one waits in the queue and the next is turned away
+  NDTECH_CHECK(!scheduler.AddTask([]() {}).IsRejected());
+  NDTECH_CHECK(scheduler.AddTask([]() {}).IsRejected());
+
+  {
+    std::lock_guard<std::mutex> guard(gateMutex);
+    open = true;
+    gateConditionVariable.notify_all();
+  }
+  scheduler.Join();
+}
+
+// A pool thread that finds the queue full under Block is rejected instead of waiting on
+// the pool it is part of
+void BlockRejectsOnPoolThreads(SchedulerMode mode) {
+  SchedulerSettings settings;
+  settings.m_mode = mode;
+  settings.m_workerCount = 2;
+  settings.m_maxQueuedTasks = 1;
+  settings.m_queueFullPolicy = QueueFullPolicy::Block;
+  Scheduler scheduler(settings);
+
+  std::atomic<size_t> finished{ 0 };
+  std::atomic<bool> firstRejected{ true };
+  std::atomic<bool> secondRejected{ false };
+
+  scheduler.AddTask([&]() {
+    // Far in the future, so it stays queued
+    auto later = Scheduler::Clock::now() + 1h;
+    firstRejected = scheduler.AddTask(std::make_pair(Task([]() {}), later)).IsRejected();
+    secondRejected = scheduler.AddTask(std::make_pair(Task([]() {}), later)).IsRejected();
+    finished++;
+  });
+
+  WaitFor(finished, 1);
+  NDTECH_CHECK(!firstRejected);
+  NDTECH_CHECK(secondRejected);
+  NDTECH_CHECK(scheduler.GetStats().m_rejectedTasks == 1);
+  scheduler.Join();
+}
+
+int main() {
+  RejectUnderFlood();
+  BlockUnderFlood();
+  DropOldestUnderFlood();
+  RunningTasksDoNotCount();
+  BlockRejectsOnPoolThreads(SchedulerMode::WorkStealing);
+  // Only one FiberPool may be created per process
+  BlockRejectsOnPoolThreads(SchedulerMode::Fibers);
+  return 0;
+}
\ No newline at end of file
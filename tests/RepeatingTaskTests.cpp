@@ -0,0 +1,133 @@
+#include "Scheduler.h"
+#include "TestCheck.h"
+
+#include <map>
+#include <mutex>
+#include <thread>
+
+using namespace ndtech;
+
+const microseconds Interval = 10ms;
+const milliseconds Stall = 200ms;
+// Deadlines the pass after the stall finds already past, besides the one that is due
+const uint64_t MissedDeadlines = Stall / Interval - 1;
+
+struct StalledRun {
+  // Runs of the repeating task in the pass that found it late, and in the passes after
+  int             m_catchUpPassRuns = 0;
+  int             m_laterPassRuns = 0;
+  int             m_passesWithRuns = 0;
+  SchedulerStats  m_stats;
+};
+
+// Adds a repeating task from inside a task that then holds the scheduler thread for
+// Stall, so the next pass finds Stall / Interval deadlines missed.  Runs are grouped by
+// the pass they ran in, which GetStats' wakeup count tells apart.
+StalledRun RunStalled(MissedDeadlinePolicy policy, SchedulerSettings settings, microseconds taskDuration) {
+  Scheduler scheduler(settings);
+
+  std::mutex runsMutex;
+  std::map<uint64_t, int> runsPerPass;
+  std::atomic<uint64_t> stallPass{ 0 };
+  std::atomic<bool> stalled{ false };
+
+  scheduler.AddTask([&]() {
+    scheduler.AddRepeatingTask([&]() {
+      uint64_t pass = scheduler.GetStats().m_wakeups;
+      std::this_thread::sleep_for(taskDuration);
+      std::lock_guard<std::mutex> guard(runsMutex);
+      runsPerPass[pass]++;
+    }, Interval, system_clock::now() + Stall + 150ms, policy);
+
+    stallPass = scheduler.GetStats().m_wakeups;
+    std::this_thread::sleep_for(Stall);
+    stalled = true;
+  });
+
+  while (!stalled) {
+    std::this_thread::sleep_for(1ms);
+  }
+  std::this_thread::sleep_for(250ms);
+
+  StalledRun run;
+  run.m_stats = scheduler.GetStats();
+  scheduler.Join();
+
+  for (auto& passRuns : runsPerPass) {
+    // Nothing can run while the scheduler thread is held
+    NDTECH_CHECK(passRuns.first > stallPass);
+    if (passRuns.first == stallPass + 1) {
+      run.m_catchUpPassRuns = passRuns.second;
+    }
+    else {
+      run.m_laterPassRuns += passRuns.second;
+    }
+    run.m_passesWithRuns++;
+  }
+
+  return run;
+}
+
+// Missed deadlines are dropped, and the task resumes at the next boundary
+void SkipDropsMissedRuns() {
+  StalledRun run = RunStalled(MissedDeadlinePolicy::Skip, SchedulerSettings{}, 0us);
+
+  NDTECH_CHECK(run.m_catchUpPassRuns == 0);
+  NDTECH_CHECK(run.m_stats.m_skippedRuns >= MissedDeadlines + 1);
+  NDTECH_CHECK(run.m_stats.m_coalescedRuns == 0);
+  NDTECH_CHECK(run.m_laterPassRuns > 0);
+  // One run per pass from then on, never a burst
+  NDTECH_CHECK(run.m_laterPassRuns == run.m_passesWithRuns);
+}
+
+// Missed deadlines become a single run
+void CoalesceRunsOnce() {
+  StalledRun run = RunStalled(MissedDeadlinePolicy::Coalesce, SchedulerSettings{}, 0us);
+
+  NDTECH_CHECK(run.m_catchUpPassRuns == 1);
+  NDTECH_CHECK(run.m_stats.m_coalescedRuns >= MissedDeadlines);
+  NDTECH_CHECK(run.m_stats.m_skippedRuns == 0);
+  NDTECH_CHECK(run.m_laterPassRuns == run.m_passesWithRuns - 1);
+}
+
+// Each missed deadline gets its run, up to m_maxCatchUpRuns, and the older ones are
+// coalesced
+void CatchUpRunsUpToTheLimit() {
+  SchedulerSettings settings;
+  settings.m_maxCatchUpRuns = 8;
+  StalledRun run = RunStalled(MissedDeadlinePolicy::CatchUp, settings, 0us);
+
+  NDTECH_CHECK(run.m_catchUpPassRuns == 1 + 8);
+  NDTECH_CHECK(run.m_stats.m_coalescedRuns >= MissedDeadlines - 8);
+  NDTECH_CHECK(run.m_stats.m_deferredCatchUpRuns == 0);
+  NDTECH_CHECK(run.m_stats.m_skippedRuns == 0);
+
+  settings.m_maxCatchUpRuns = 3;
+  run = RunStalled(MissedDeadlinePolicy::CatchUp, settings, 0us);
+
+  NDTECH_CHECK(run.m_catchUpPassRuns == 1 + 3);
+  NDTECH_CHECK(run.m_stats.m_coalescedRuns >= MissedDeadlines - 3);
+}
+
+// Catch-up runs past the pass's budget are deferred to later passes, not dropped
+void CatchUpDefersPastTheBudget() {
+  SchedulerSettings settings;
+  settings.m_maxCatchUpRuns = 8;
+  settings.m_catchUpBudget = 1500us;
+  StalledRun run = RunStalled(MissedDeadlinePolicy::CatchUp, settings, 1000us);
+
+  // The first run always happens, and nine would take at least 9 ms
+  NDTECH_CHECK(run.m_catchUpPassRuns >= 1 && run.m_catchUpPassRuns < 1 + 8);
+  NDTECH_CHECK(run.m_stats.m_deferredCatchUpRuns >= 1);
+  NDTECH_CHECK(run.m_stats.m_coalescedRuns >= MissedDeadlines - 8);
+  // The owed runs still happen in the passes that follow
+  NDTECH_CHECK(run.m_catchUpPassRuns + run.m_laterPassRuns >= 1 + 8);
+}
+
+int main() {
+  SkipDropsMissedRuns();
+  CoalesceRunsOnce();
+  CatchUpRunsUpToTheLimit();
+  CatchUpDefersPastTheBudget();
+  return 0;
+}
\ No newline at end of file
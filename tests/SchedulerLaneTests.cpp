@@ -0,0 +1,178 @@
+#include "Scheduler.h"
+#include "StepTimer.h"
+#include "TestCheck.h"
+
+#include <mutex>
+#include <string>
+#include <thread>
+
+using namespace ndtech;
+
+void WaitFor(std::atomic<int>& counter, int target) {
+  auto deadline = steady_clock::now() + 30s;
+  while (counter.load() < target) {
+    NDTECH_CHECK(steady_clock::now() < deadline);
+    std::this_thread::sleep_for(1ms);
+  }
+}
+
+void Spin(microseconds duration) {
+  auto end = steady_clock::now() + duration;
+  while (steady_clock::now() < end) {
+  }
+}
+
+// Critical tasks added while a background task runs go ahead of the background tasks
+// queued behind it.  PerFrame and Idle tasks wait for the thread that drains them.
+void CriticalLaneRunsFirst() {
+  Scheduler scheduler;
+
+  std::mutex orderMutex;
+  std::vector<std::string> order;
+  auto record = [&](std::string name) {
+    std::lock_guard<std::mutex> guard(orderMutex);
+    order.push_back(std::move(name));
+  };
+
+  std::atomic<bool> release{ false };
+  std::atomic<int> started{ 0 };
+  std::atomic<int> finished{ 0 };
+  scheduler.AddTask([&]() {
+    started++;
+    while (!release.load()) {
+      std::this_thread::yield();
+    }
+    record("b0");
+    finished++;
+  });
+  WaitFor(started, 1);
+
+  for (int index = 1; index <= 5; index++) {
+    scheduler.AddTask([&, index]() { record("b" + std::to_string(index)); finished++; });
+  }
+  for (int index = 1; index <= 3; index++) {
+    scheduler.AddTask([&, index]() { record("c" + std::to_string(index)); finished++; }, TaskLane::Critical);
+  }
+  std::thread::id frameThread;
+  scheduler.AddTask([&]() { frameThread = std::this_thread::get_id(); finished++; }, TaskLane::PerFrame);
+  scheduler.AddTask([&]() { record("idle"); finished++; }, TaskLane::Idle);
+
+  release = true;
+  WaitFor(finished, 9);
+  std::this_thread::sleep_for(20ms);
+
+  std::vector<std::string> expected{ "b0", "c1", "c2", "c3", "b1", "b2", "b3", "b4", "b5" };
+  {
+    std::lock_guard<std::mutex> guard(orderMutex);
+    NDTECH_CHECK(order == expected);
+  }
+  NDTECH_CHECK(finished == 9);
+
+  scheduler.RunFrameTasks();
+  NDTECH_CHECK(finished == 10);
+  NDTECH_CHECK(frameThread == std::this_thread::get_id());
+
+  scheduler.RunIdleTasks(1000us);
+  NDTECH_CHECK(finished == 11);
+  NDTECH_CHECK(order.back() == "idle");
+
+  SchedulerStats stats = scheduler.GetStats();
+  NDTECH_CHECK(stats.m_lanes[static_cast<size_t>(TaskLane::Critical)].m_tasksRun == 3);
+  NDTECH_CHECK(stats.m_lanes[static_cast<size_t>(TaskLane::PerFrame)].m_tasksRun == 1);
+  NDTECH_CHECK(stats.m_lanes[static_cast<size_t>(TaskLane::Idle)].m_tasksRun == 1);
+
+  scheduler.Join();
+}
+
+// RunFrameTasks stops once its budget is spent and leaves the rest, in order, for the
+// next frame
+void FrameTasksStopAtTheBudget() {
+  Scheduler scheduler;
+
+  const int taskCount = 40;
+  std::vector<int> order;
+  for (int index = 0; index < taskCount; index++) {
+    scheduler.AddTask([&order, index]() {
+      Spin(1000us);
+      order.push_back(index);
+    }, TaskLane::PerFrame);
+  }
+
+  scheduler.RunFrameTasks(5000us);
+  NDTECH_CHECK(order.size() >= 1 && order.size() <= 5);
+
+  int frames = 1;
+  while (order.size() < taskCount) {
+    size_t before = order.size();
+    scheduler.RunFrameTasks(5000us);
+    NDTECH_CHECK(order.size() > before && order.size() - before <= 5);
+    frames++;
+  }
+  NDTECH_CHECK(frames >= taskCount / 5);
+  for (int index = 0; index < taskCount; index++) {
+    NDTECH_CHECK(order[index] == index);
+  }
+
+  // A task that takes longer than the whole budget still runs, and counts as an overrun
+  scheduler.AddTask([]() { Spin(3000us); }, TaskLane::PerFrame);
+  scheduler.AddTask([]() {}, TaskLane::PerFrame);
+  scheduler.RunFrameTasks(1000us);
+  LaneStats frameStats = scheduler.GetStats().m_lanes[static_cast<size_t>(TaskLane::PerFrame)];
+  NDTECH_CHECK(frameStats.m_tasksRun == taskCount + 1);
+  NDTECH_CHECK(frameStats.m_budgetOverruns >= 1);
+
+  scheduler.Join();
+}
+
+// Idle tasks run only for the slack they are given, and not at all without any
+void IdleTasksStayWithinTheSlack() {
+  Scheduler scheduler;
+
+  std::atomic<int> runs{ 0 };
+  for (int index = 0; index < 20; index++) {
+    scheduler.AddTask([&runs]() {
+      Spin(1000us);
+      runs++;
+    }, TaskLane::Idle);
+  }
+
+  scheduler.RunIdleTasks(0us);
+  scheduler.RunIdleTasks(-5000us);
+  NDTECH_CHECK(runs == 0);
+
+  auto start = steady_clock::now();
+  scheduler.RunIdleTasks(3000us);
+  auto spent = steady_clock::now() - start;
+  NDTECH_CHECK(runs >= 1 && runs <= 3);
+  NDTECH_CHECK(spent < 20ms);
+
+  scheduler.RunIdleTasks(1s);
+  NDTECH_CHECK(runs == 20);
+
+  scheduler.Join();
+}
+
+// The slack App::Loop turns into the idle budget is the rest of the target frame time
+void FrameSlackIsTheRestOfTheFrame() {
+  NDTECH_CHECK(StepTimer::GetPerformanceFrequency() == StepTimer::TicksPerSecond);
+
+  StepTimer timer;
+  timer.SetTargetElapsedSeconds(0.05);
+  timer.Tick([]() {});
+
+  std::this_thread::sleep_for(10ms);
+  double slack = timer.GetFrameSlackSeconds();
+  NDTECH_CHECK(slack > 0.0);
+  NDTECH_CHECK(slack <= 0.04);
+
+  std::this_thread::sleep_for(50ms);
+  NDTECH_CHECK(timer.GetFrameSlackTicks() < 0);
+}
+
+int main() {
+  CriticalLaneRunsFirst();
+  FrameTasksStopAtTheBudget();
+  IdleTasksStayWithinTheSlack();
+  FrameSlackIsTheRestOfTheFrame();
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,181 @@
+#include "Scheduler.h"
+#include "SchedulerTrace.h"
+#include "TestCheck.h"
+
+#include <map>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace ndtech;
+
+static_assert(NDTECH_SCHEDULER_TRACING, "SchedulerTraceTests must link ndtech_headless_traced");
+
+struct ParsedEvent {
+  std::string   m_name;
+  int           m_threadId;
+  double        m_beginMicroseconds;
+  double        m_durationMicroseconds;
+  double        m_queuedMicroseconds;
+  bool          m_hasQueued;
+};
+
+// Parses what WriteChromeTrace emits, one complete event per line between the header and
+// the footer, and fails on anything else
+std::vector<ParsedEvent> ParseChromeTrace(const std::string& trace) {
+  static const std::regex eventPattern(
+    R"re(\{"name":"([^"\\]*)","cat":"ndtech","ph":"X","pid":1,"tid":(\d+),"ts":(-?[0-9]+\.[0-9]{3}),"dur":([0-9]+\.[0-9]{3})(,"args":\{"queued_us":([0-9]+\.[0-9]{3})\})?\},?)re");
+
+  std::istringstream stream(trace);
+  std::string line;
+  NDTECH_CHECK(std::getline(stream, line) && line == "{\"traceEvents\":[");
+
+  std::vector<ParsedEvent> events;
+  bool footer = false;
+  bool separated = true;
+  while (std::getline(stream, line)) {
+    if (line == "],\"displayTimeUnit\":\"ns\"}") {
+      footer = true;
+      break;
+    }
+
+    // Every event but the last is followed by a comma
+    NDTECH_CHECK(separated);
+    separated = line.back() == ',';
+
+    std::smatch match;
+    NDTECH_CHECK(std::regex_match(line, match, eventPattern));
+    events.push_back(ParsedEvent{ match[1], std::stoi(match[2]), std::stod(match[3]), std::stod(match[4]), match[6].matched ? std::stod(match[6]) : 0.0, match[6].matched });
+  }
+  NDTECH_CHECK(footer);
+  NDTECH_CHECK(events.empty() || !separated);
+  NDTECH_CHECK(!std::getline(stream, line));
+
+  return events;
+}
+
+std::string DumpTrace() {
+  std::ostringstream stream;
+  Tracer::WriteChromeTrace(stream);
+  return stream.str();
+}
+
+// Tasks on each lane and on the workers show up as events with the time they waited
+void RecordsSchedulerTasks() {
+  Tracer::Clear();
+  Tracer::Enable(true);
+
+  const int taskCount = 100;
+  std::atomic<int> runs{ 0 };
+  {
+    Scheduler scheduler;
+    for (int index = 0; index < taskCount; index++) {
+      scheduler.AddTask([&runs]() { runs++; });
+      scheduler.AddTask([&runs]() { runs++; }, TaskLane::Critical);
+      scheduler.AddTask([&runs]() { runs++; }, TaskLane::PerFrame);
+    }
+    while (runs < 2 * taskCount) {
+      std::this_thread::sleep_for(1ms);
+    }
+    scheduler.RunFrameTasks(1s);
+    scheduler.Join();
+  }
+
+  {
+    SchedulerSettings settings;
+    settings.m_mode = SchedulerMode::WorkStealing;
+    settings.m_workerCount = 2;
+    Scheduler scheduler(settings);
+    for (int index = 0; index < taskCount; index++) {
+      scheduler.AddTask([&runs]() { runs++; });
+    }
+    while (runs < 4 * taskCount) {
+      std::this_thread::sleep_for(1ms);
+    }
+    scheduler.Join();
+  }
+
+  Tracer::Enable(false);
+  NDTECH_CHECK(runs == 4 * taskCount);
+
+  std::vector<ParsedEvent> events = ParseChromeTrace(DumpTrace());
+
+  std::map<std::string, int> counts;
+  for (const ParsedEvent& event : events) {
+    counts[event.m_name]++;
+    NDTECH_CHECK(event.m_threadId > 0);
+    NDTECH_CHECK(event.m_durationMicroseconds >= 0.0);
+
+    // Only NDTECH_TRACE_TASK events, all named "... task", carry the time queued
+    bool isTask = event.m_name == "Task" || (event.m_name.size() > 5 && event.m_name.compare(event.m_name.size() - 5, 5, " task") == 0);
+    NDTECH_CHECK(event.m_hasQueued == isTask);
+    NDTECH_CHECK(event.m_queuedMicroseconds >= 0.0);
+  }
+  NDTECH_CHECK(counts["Task"] == taskCount);
+  NDTECH_CHECK(counts["Critical task"] == taskCount);
+  NDTECH_CHECK(counts["Frame task"] == taskCount);
+  NDTECH_CHECK(counts["Worker task"] == taskCount);
+  NDTECH_CHECK(counts["Scheduler::ProcessReadyTasks"] > 0);
+
+  // Nothing is recorded while disabled, and Clear forgets what was
+  {
+    Scheduler scheduler;
+    scheduler.AddTask([&runs]() { runs++; });
+    while (runs < 4 * taskCount + 1) {
+      std::this_thread::sleep_for(1ms);
+    }
+    scheduler.Join();
+  }
+  NDTECH_CHECK(ParseChromeTrace(DumpTrace()).size() == events.size());
+
+  Tracer::Clear();
+  NDTECH_CHECK(ParseChromeTrace(DumpTrace()).empty());
+}
+
+// Dumps taken while workers keep recording are complete JSON, and tracing carries on
+// afterwards
+void DumpsWhileTasksRun() {
+  Tracer::Clear();
+  Tracer::Enable(true);
+
+  SchedulerSettings settings;
+  settings.m_mode = SchedulerMode::WorkStealing;
+  settings.m_workerCount = 4;
+  Scheduler scheduler(settings);
+
+  std::atomic<bool> stop{ false };
+  std::atomic<int> runs{ 0 };
+  std::thread producer([&]() {
+    int added = 0;
+    while (!stop.load()) {
+      // Keep the workers busy without letting the queue grow without bound
+      if (added - runs.load() > 1000) {
+        std::this_thread::yield();
+        continue;
+      }
+      scheduler.AddTask([&runs]() { runs++; });
+      added++;
+    }
+  });
+
+  size_t mostEvents = 0;
+  for (int dump = 0; dump < 20; dump++) {
+    std::this_thread::sleep_for(5ms);
+    std::vector<ParsedEvent> events = ParseChromeTrace(DumpTrace());
+    NDTECH_CHECK(Tracer::IsEnabled());
+    mostEvents = std::max(mostEvents, events.size());
+  }
+  NDTECH_CHECK(mostEvents > 0);
+
+  stop = true;
+  producer.join();
+  scheduler.Join();
+  Tracer::Enable(false);
+}
+
+int main() {
+  RecordsSchedulerTasks();
+  DumpsWhileTasksRun();
+  return 0;
+}
\ No newline at end of file
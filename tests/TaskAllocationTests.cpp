@@ -0,0 +1,113 @@
+#include "Scheduler.h"
+#include "TestCheck.h"
+
+#include <cstdlib>
+#include <new>
+
+using namespace ndtech;
+
+// Counts every allocation in the process, on every thread
+std::atomic<size_t> g_allocations{ 0 };
+
+void* operator new(size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  void* storage = std::malloc(size > 0 ? size : 1);
+  if (storage == nullptr) {
+    throw std::bad_alloc();
+  }
+  return storage;
+}
+
+void operator delete(void* storage) noexcept {
+  std::free(storage);
+}
+
+void operator delete(void* storage, size_t) noexcept {
+  std::free(storage);
+}
+
+struct LargeCapture {
+  char m_bytes[200];
+};
+
+// Adds burstSize tasks with inline captures and burstSize with captures boxed in the
+// task pools, under coalescingTag when it is not NoCoalescingTag, and waits for them
+void RunBurst(Scheduler& scheduler, size_t burstSize, uint64_t coalescingTag) {
+  std::atomic<size_t> finished{ 0 };
+  size_t expected = 0;
+  uint64_t coalescedBefore = scheduler.GetStats().m_coalescedTasks;
+
+  for (size_t index = 0; index < burstSize; index++) {
+    char smallCapture[40] = {};
+    LargeCapture largeCapture{};
+
+    Task small([&finished, smallCapture]() { finished++; (void)smallCapture; });
+    Task large([&finished, largeCapture]() { finished++; (void)largeCapture; });
+
+    expected += scheduler.AddTask(std::move(small), coalescingTag).IsRejected() ? 0 : 1;
+    expected += scheduler.AddTask(std::move(large), coalescingTag).IsRejected() ? 0 : 1;
+  }
+
+  auto deadline = steady_clock::now() + 30s;
+  while (finished.load() + (scheduler.GetStats().m_coalescedTasks - coalescedBefore) < expected) {
+    NDTECH_CHECK(steady_clock::now() < deadline);
+    std::this_thread::sleep_for(1ms);
+  }
+}
+
+// The pools, queues and rings grow to however much work is in flight at once, which
+// depends on how the threads interleave, so a burst after warm-up may still find one of
+// them a block short.  Steady state means that happens a bounded number of times, not
+// once per task: some burst has to allocate nothing, and all of them together may only
+// allocate a handful of times.
+void CheckSteadyState(SchedulerSettings settings, uint64_t coalescingTag, const char* name) {
+  Scheduler scheduler(settings);
+
+  const size_t burstSize = 5000;
+  const size_t measuredBursts = 10;
+  RunBurst(scheduler, burstSize, coalescingTag);
+  RunBurst(scheduler, burstSize, coalescingTag);
+
+  size_t totalAllocations = 0;
+  size_t quietBursts = 0;
+  for (size_t burst = 0; burst < measuredBursts; burst++) {
+    size_t before = g_allocations.load();
+    RunBurst(scheduler, burstSize, coalescingTag);
+    size_t allocations = g_allocations.load() - before;
+
+    totalAllocations += allocations;
+    quietBursts += allocations == 0 ? 1 : 0;
+  }
+
+  scheduler.Join();
+
+  std::printf("%s: %zu allocations for %zu tasks, %zu of %zu bursts allocated nothing\n", name, totalAllocations, measuredBursts * burstSize * 2, quietBursts, measuredBursts);
+  NDTECH_CHECK(quietBursts > 0);
+  NDTECH_CHECK(totalAllocations < 64);
+}
+
+int main() {
+  {
+    SchedulerSettings settings;
+    CheckSteadyState(settings, Scheduler::NoCoalescingTag, "SingleThread");
+  }
+
+  {
+    SchedulerSettings settings;
+    settings.m_mode = SchedulerMode::WorkStealing;
+    settings.m_workerCount = 4;
+    CheckSteadyState(settings, Scheduler::NoCoalescingTag, "WorkStealing");
+  }
+
+  // Tagged tasks are also tracked for DropOldest
+  {
+    SchedulerSettings settings;
+    settings.m_mode = SchedulerMode::WorkStealing;
+    settings.m_workerCount = 4;
+    settings.m_maxQueuedTasks = 256;
+    settings.m_queueFullPolicy = QueueFullPolicy::DropOldest;
+    CheckSteadyState(settings, 7, "WorkStealing with DropOldest");
+  }
+
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,132 @@
+#include "TaskGraph.h"
+#include "TestCheck.h"
+
+#include <stdexcept>
+
+using namespace ndtech;
+
+// A diamond runs in dependency order, frame after frame
+void RunsInDependencyOrder(Scheduler& scheduler) {
+  TaskGraph graph;
+  std::atomic<int> order{ 0 };
+  int first = -1;
+  int last = -1;
+
+  TaskGraph::NodeId top = graph.AddNode([&]() { first = order++; std::this_thread::sleep_for(1ms); });
+  TaskGraph::NodeId left = graph.AddNode([&]() { order++; std::this_thread::sleep_for(2ms); });
+  TaskGraph::NodeId right = graph.AddNode([&]() { order++; std::this_thread::sleep_for(2ms); });
+  TaskGraph::NodeId bottom = graph.AddNode([&]() { last = order++; });
+  graph.AddEdge(top, left);
+  graph.AddEdge(top, right);
+  graph.AddEdge(left, bottom);
+  graph.AddEdge(right, bottom);
+
+  for (int frame = 0; frame < 20; frame++) {
+    order = 0;
+    NDTECH_CHECK(graph.Run(scheduler));
+    NDTECH_CHECK(first == 0);
+    NDTECH_CHECK(last == 3);
+    NDTECH_CHECK(graph.CriticalPathTime() >= 3ms);
+    NDTECH_CHECK(graph.LastRunTime() >= graph.CriticalPathTime());
+  }
+}
+
+void RejectsCycles(Scheduler& scheduler) {
+  TaskGraph graph;
+  bool ran = false;
+  TaskGraph::NodeId first = graph.AddNode([&]() { ran = true; });
+  TaskGraph::NodeId second = graph.AddNode([&]() { ran = true; });
+  graph.AddEdge(first, second);
+  graph.AddEdge(second, first);
+
+  NDTECH_CHECK(!graph.Run(scheduler));
+  NDTECH_CHECK(!ran);
+}
+
+// The first exception comes out of Run once the graph has drained, nodes after the one
+// that threw are skipped, and the graph can run again
+void RethrowsNodeExceptions(Scheduler& scheduler) {
+  TaskGraph graph;
+  bool shouldThrow = true;
+  std::atomic<int> afterRuns{ 0 };
+  std::atomic<int> siblingRuns{ 0 };
+
+  TaskGraph::NodeId root = graph.AddNode([]() {});
+  TaskGraph::NodeId thrower = graph.AddNode([&]() {
+    if (shouldThrow) {
+      throw std::runtime_error("node failed");
+    }
+  });
+  TaskGraph::NodeId sibling = graph.AddNode([&]() { siblingRuns++; });
+  TaskGraph::NodeId after = graph.AddNode([&]() { afterRuns++; });
+  graph.AddEdge(root, thrower);
+  graph.AddEdge(root, sibling);
+  graph.AddEdge(thrower, after);
+
+  bool caught = false;
+  try {
+    graph.Run(scheduler);
+  }
+  catch (const std::runtime_error& error) {
+    caught = std::string(error.what()) == "node failed";
+  }
+  NDTECH_CHECK(caught);
+  NDTECH_CHECK(afterRuns == 0);
+
+  shouldThrow = false;
+  int siblingRunsBefore = siblingRuns;
+  NDTECH_CHECK(graph.Run(scheduler));
+  NDTECH_CHECK(afterRuns == 1);
+  NDTECH_CHECK(siblingRuns == siblingRunsBefore + 1);
+}
+
+// With the queue full, rejected nodes run on the thread that tried to add them instead
+// of leaving Run waiting
+void RunsRejectedNodesInline() {
+  SchedulerSettings settings;
+  settings.m_mode = SchedulerMode::WorkStealing;
+  settings.m_workerCount = 1;
+  settings.m_maxQueuedTasks = 1;
+  settings.m_queueFullPolicy = QueueFullPolicy::Reject;
+  Scheduler scheduler(settings);
+
+  // Holds the only place in the queue for the whole run
+  auto later = Scheduler::Clock::now() + 1h;
+  NDTECH_CHECK(!scheduler.AddTask(std::make_pair(Task([]() {}), later)).IsRejected());
+
+  TaskGraph graph;
+  std::atomic<int> runs{ 0 };
+  TaskGraph::NodeId previous = graph.AddNode([&]() { runs++; });
+  for (int node = 0; node < 10; node++) {
+    TaskGraph::NodeId next = graph.AddNode([&]() { runs++; });
+    graph.AddEdge(previous, next);
+    previous = next;
+  }
+  for (int node = 0; node < 10; node++) {
+    graph.AddNode([&]() { runs++; });
+  }
+
+  NDTECH_CHECK(graph.Run(scheduler));
+  NDTECH_CHECK(runs == 21);
+  NDTECH_CHECK(scheduler.GetStats().m_rejectedTasks > 0);
+
+  scheduler.Join();
+}
+
+int main() {
+  for (SchedulerMode mode : { SchedulerMode::SingleThread, SchedulerMode::WorkStealing }) {
+    SchedulerSettings settings;
+    settings.m_mode = mode;
+    settings.m_workerCount = 4;
+    Scheduler scheduler(settings);
+
+    RunsInDependencyOrder(scheduler);
+    RejectsCycles(scheduler);
+    RethrowsNodeExceptions(scheduler);
+
+    scheduler.Join();
+  }
+
+  RunsRejectedNodesInline();
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include "Scheduler.h"
+#include "TestCheck.h"
+
+#include <thread>
+
+// Built as C++20, the only place TaskHandle's awaiter is compiled
+#if !defined(__cpp_impl_coroutine)
+#error "TaskHandleCoroutineTests needs coroutine support"
+#endif
+
+using namespace ndtech;
+
+// Starts at once and frees its frame when it finishes, so a test only has to wait for
+// the flags the coroutine sets
+struct DetachedCoroutine {
+  struct promise_type {
+    DetachedCoroutine get_return_object() { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+struct AwaitResult {
+  std::atomic<bool>   m_resumed{ false };
+  std::atomic<bool>   m_suspended{ false };
+  std::thread::id     m_resumedOn;
+};
+
+DetachedCoroutine AwaitTask(TaskHandle handle, AwaitResult& result) {
+  result.m_suspended = true;
+  co_await handle;
+  result.m_resumedOn = std::this_thread::get_id();
+  result.m_resumed = true;
+}
+
+void WaitUntil(const std::atomic<bool>& flag) {
+  auto deadline = steady_clock::now() + 30s;
+  while (!flag.load()) {
+    NDTECH_CHECK(steady_clock::now() < deadline);
+    std::this_thread::sleep_for(1ms);
+  }
+}
+
+// The coroutine resumes after the task has run, on the thread that ran it
+void ResumesAfterTheTask() {
+  Scheduler scheduler;
+
+  std::atomic<bool> release{ false };
+  std::atomic<bool> ran{ false };
+  std::thread::id taskThread;
+  TaskHandle handle = scheduler.AddTask([&]() {
+    while (!release) {
+      std::this_thread::yield();
+    }
+    taskThread = std::this_thread::get_id();
+    ran = true;
+  });
+
+  AwaitResult result;
+  AwaitTask(handle, result);
+  NDTECH_CHECK(result.m_suspended);
+  NDTECH_CHECK(!result.m_resumed);
+
+  release = true;
+  WaitUntil(result.m_resumed);
+  NDTECH_CHECK(ran);
+  NDTECH_CHECK(result.m_resumedOn == taskThread);
+  NDTECH_CHECK(result.m_resumedOn != std::this_thread::get_id());
+
+  scheduler.Join();
+}
+
+// A handle that is already done, empty or rejected does not suspend
+void DoneHandlesDoNotSuspend() {
+  Scheduler scheduler;
+
+  TaskHandle handle = scheduler.AddTask([]() {});
+  while (!handle.IsDone()) {
+    std::this_thread::sleep_for(1ms);
+  }
+
+  for (TaskHandle done : { handle, TaskHandle{}, TaskHandle::Rejected() }) {
+    AwaitResult result;
+    AwaitTask(done, result);
+    NDTECH_CHECK(result.m_resumed);
+    NDTECH_CHECK(result.m_resumedOn == std::this_thread::get_id());
+  }
+
+  scheduler.Join();
+}
+
+// Cancelling a task or dropping it at Join still resumes whoever awaits it
+void ResumesWhenTheTaskIsDropped() {
+  Scheduler scheduler;
+
+  std::atomic<bool> ran{ false };
+  TaskHandle cancelled = scheduler.AddTask(std::make_pair(Task([&ran]() { ran = true; }), Scheduler::Clock::now() + 50ms));
+  AwaitResult cancelledResult;
+  AwaitTask(cancelled, cancelledResult);
+  NDTECH_CHECK(cancelled.Cancel());
+  WaitUntil(cancelledResult.m_resumed);
+
+  TaskHandle dropped = scheduler.AddTask(std::make_pair(Task([&ran]() { ran = true; }), Scheduler::Clock::now() + 1h));
+  AwaitResult droppedResult;
+  AwaitTask(dropped, droppedResult);
+  NDTECH_CHECK(!droppedResult.m_resumed);
+
+  scheduler.Join();
+  NDTECH_CHECK(droppedResult.m_resumed);
+  NDTECH_CHECK(droppedResult.m_resumedOn == std::this_thread::get_id());
+  NDTECH_CHECK(!ran);
+}
+
+int main() {
+  ResumesAfterTheTask();
+  DoneHandlesDoNotSuspend();
+  ResumesWhenTheTaskIsDropped();
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+#include "Scheduler.h"
+#include "TestCheck.h"
+
+#include <thread>
+
+using namespace ndtech;
+
+void WaitUntil(const std::atomic<bool>& flag) {
+  auto deadline = steady_clock::now() + 30s;
+  while (!flag.load()) {
+    NDTECH_CHECK(steady_clock::now() < deadline);
+    std::this_thread::sleep_for(1ms);
+  }
+}
+
+void WaitUntilDone(const TaskHandle& handle) {
+  auto deadline = steady_clock::now() + 30s;
+  while (!handle.IsDone()) {
+    NDTECH_CHECK(steady_clock::now() < deadline);
+    std::this_thread::sleep_for(1ms);
+  }
+}
+
+// A cancelled task never runs, and its handle reports it done at once.  A task that
+// has started or finished can no longer be cancelled.
+void CancelledTasksNeverRun(SchedulerMode mode) {
+  SchedulerSettings settings;
+  settings.m_mode = mode;
+  settings.m_workerCount = 2;
+  Scheduler scheduler(settings);
+
+  std::atomic<bool> cancelledRan{ false };
+  TaskHandle cancelled = scheduler.AddTask(std::make_pair(Task([&cancelledRan]() { cancelledRan = true; }), Scheduler::Clock::now() + 50ms));
+  NDTECH_CHECK(cancelled);
+  NDTECH_CHECK(!cancelled.IsDone());
+  NDTECH_CHECK(cancelled.Cancel());
+  NDTECH_CHECK(cancelled.IsDone());
+  NDTECH_CHECK(!cancelled.Cancel());
+
+  std::atomic<bool> started{ false };
+  std::atomic<bool> release{ false };
+  TaskHandle running = scheduler.AddTask([&]() {
+    started = true;
+    while (!release) {
+      std::this_thread::yield();
+    }
+  });
+  WaitUntil(started);
+  NDTECH_CHECK(!running.IsDone());
+  NDTECH_CHECK(!running.Cancel());
+  release = true;
+  WaitUntilDone(running);
+  NDTECH_CHECK(!running.Cancel());
+
+  std::this_thread::sleep_for(100ms);
+  NDTECH_CHECK(!cancelledRan);
+
+  // Join drops what is still queued, which finishes its handle without running it
+  std::atomic<bool> droppedRan{ false };
+  TaskHandle dropped = scheduler.AddTask(std::make_pair(Task([&droppedRan]() { droppedRan = true; }), Scheduler::Clock::now() + 1h));
+  NDTECH_CHECK(!dropped.IsDone());
+  scheduler.Join();
+  NDTECH_CHECK(dropped.IsDone());
+  NDTECH_CHECK(!droppedRan);
+}
+
+// IsDone turns true only once the task has run, on every lane
+void IsDoneFollowsTheTask() {
+  Scheduler scheduler;
+
+  std::atomic<bool> release{ false };
+  std::atomic<bool> ran{ false };
+  TaskHandle background = scheduler.AddTask([&]() {
+    while (!release) {
+      std::this_thread::yield();
+    }
+    ran = true;
+  });
+  TaskHandle frame = scheduler.AddTask([]() {}, TaskLane::PerFrame);
+  TaskHandle idle = scheduler.AddTask([]() {}, TaskLane::Idle);
+
+  NDTECH_CHECK(!background.IsDone());
+  NDTECH_CHECK(!frame.IsDone());
+  NDTECH_CHECK(!idle.IsDone());
+
+  release = true;
+  WaitUntilDone(background);
+  NDTECH_CHECK(ran);
+
+  scheduler.RunFrameTasks();
+  NDTECH_CHECK(frame.IsDone());
+  NDTECH_CHECK(!idle.IsDone());
+  scheduler.RunIdleTasks(1000us);
+  NDTECH_CHECK(idle.IsDone());
+
+  // An empty handle has nothing to wait for or cancel
+  TaskHandle empty;
+  NDTECH_CHECK(!empty);
+  NDTECH_CHECK(empty.IsDone());
+  NDTECH_CHECK(!empty.Cancel());
+  NDTECH_CHECK(!empty.IsRejected());
+  NDTECH_CHECK(TaskHandle::Rejected().IsRejected());
+
+  scheduler.Join();
+}
+
+int main() {
+  CancelledTasksNeverRun(SchedulerMode::SingleThread);
+  CancelledTasksNeverRun(SchedulerMode::WorkStealing);
+  IsDoneFollowsTheTask();
+  return 0;
+}
\ No newline at end of file
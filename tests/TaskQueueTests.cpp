@@ -0,0 +1,189 @@
+#include "TaskQueue.h"
+#include "Scheduler.h"
+#include "TestCheck.h"
+
+#include <random>
+
+using namespace ndtech;
+
+using Entry = TimedEntry<int, time_point<steady_clock>>;
+
+// Earliest first, and in the order added among equal times
+void HeapPopsInTimeThenSequenceOrder() {
+  auto origin = steady_clock::now();
+  std::mt19937_64 random(1);
+
+  TaskHeap<Entry> heap;
+  for (int index = 0; index < 100000; index++) {
+    heap.Push(Entry{ index, origin + microseconds(random() % 1000), static_cast<uint64_t>(index) });
+  }
+
+  std::vector<Entry> ready;
+  heap.PopReady(origin + microseconds(500), ready);
+  NDTECH_CHECK(!ready.empty());
+  for (size_t index = 1; index < ready.size(); index++) {
+    NDTECH_CHECK(ready[index - 1].m_time <= ready[index].m_time);
+    if (ready[index - 1].m_time == ready[index].m_time) {
+      NDTECH_CHECK(ready[index - 1].m_sequence < ready[index].m_sequence);
+    }
+  }
+  NDTECH_CHECK(ready.back().m_time <= origin + microseconds(500));
+
+  time_point<steady_clock> nextTime;
+  NDTECH_CHECK(heap.NextTime(nextTime));
+  NDTECH_CHECK(nextTime > origin + microseconds(500));
+  NDTECH_CHECK(heap.Size() + ready.size() == 100000);
+}
+
+// The wheel only orders within a tick, but must release exactly what the heap releases
+void WheelReleasesWhatHeapReleases() {
+  auto origin = steady_clock::now();
+  std::mt19937_64 random(2);
+
+  TimerWheel<Entry> wheel(origin, microseconds(1000));
+  TaskHeap<Entry> heap;
+
+  const size_t entryCount = 200000;
+  for (size_t index = 0; index < entryCount; index++) {
+    // Spread over every level of the wheel
+    auto time = origin + microseconds(random() % 100000000);
+    wheel.Push(Entry{ static_cast<int>(index), time, index });
+    heap.Push(Entry{ static_cast<int>(index), time, index });
+  }
+
+  std::vector<Entry> wheelReady;
+  std::vector<Entry> heapReady;
+  size_t released = 0;
+  for (auto now = origin; released < entryCount; now += microseconds(random() % 50000)) {
+    wheelReady.clear();
+    heapReady.clear();
+    wheel.PopReady(now, wheelReady);
+    heap.PopReady(now, heapReady);
+
+    NDTECH_CHECK(wheelReady.size() == heapReady.size());
+    for (const Entry& entry : wheelReady) {
+      NDTECH_CHECK(entry.m_time <= now);
+    }
+    NDTECH_CHECK(wheel.Size() == heap.Size());
+
+    time_point<steady_clock> wheelNext;
+    time_point<steady_clock> heapNext;
+    if (wheel.NextTime(wheelNext) && heap.NextTime(heapNext)) {
+      NDTECH_CHECK(wheelNext <= heapNext);
+    }
+
+    released += wheelReady.size();
+  }
+}
+
+// A sparse wheel, where an entry waiting in a higher level is due before the only
+// occupied level-0 slot
+void WheelNextTimeLooksAtEveryLevel() {
+  auto origin = steady_clock::now();
+
+  TimerWheel<Entry> wheel(origin, milliseconds(1));
+  wheel.Push(Entry{ 0, origin + milliseconds(260), 0 });
+
+  std::vector<Entry> ready;
+  wheel.PopReady(origin + milliseconds(100), ready);
+  NDTECH_CHECK(ready.empty());
+
+  wheel.Push(Entry{ 1, origin + milliseconds(300), 1 });
+
+  time_point<steady_clock> nextTime;
+  NDTECH_CHECK(wheel.NextTime(nextTime));
+  NDTECH_CHECK(nextTime <= origin + milliseconds(260));
+  NDTECH_CHECK(nextTime > origin + milliseconds(100));
+
+  wheel.PopReady(origin + milliseconds(260), ready);
+  NDTECH_CHECK(ready.size() == 1 && ready[0].m_payload == 0);
+  NDTECH_CHECK(wheel.NextTime(nextTime));
+  NDTECH_CHECK(nextTime == origin + milliseconds(300));
+}
+
+// Delayed tasks added out of order still run by deadline
+void SchedulerRunsDelayedTasksByDeadline() {
+  Scheduler scheduler;
+  std::mt19937_64 random(3);
+
+  const int taskCount = 2000;
+  std::mutex runMutex;
+  std::vector<Scheduler::TimePoint> deadlines;
+  std::atomic<int> runTasks{ 0 };
+
+  auto origin = Scheduler::Clock::now();
+  for (int index = 0; index < taskCount; index++) {
+    Scheduler::TimePoint deadline = origin + milliseconds(20 + random() % 80);
+    scheduler.AddTask(std::make_pair(Task([&, deadline]() {
+      std::lock_guard<std::mutex> guard(runMutex);
+      deadlines.push_back(deadline);
+      runTasks++;
+    }), deadline));
+  }
+
+  while (runTasks < taskCount) {
+    std::this_thread::sleep_for(1ms);
+  }
+  scheduler.Join();
+
+  for (size_t index = 1; index < deadlines.size(); index++) {
+    NDTECH_CHECK(deadlines[index - 1] <= deadlines[index]);
+  }
+}
+
+// Repeating tasks through the Scheduler's timer wheel.  The 260 ms task waits in level 1
+// while a later one goes into level 0, and the one-shot tasks make the scheduler thread
+// work out its wake time again in between, the case NextTime used to get wrong.
+void SchedulerRunsRepeatingTasksThroughTheWheel() {
+  SchedulerSettings settings;
+  settings.m_useTimerWheel = true;
+  Scheduler scheduler(settings);
+
+  std::atomic<int> sparseRuns{ 0 };
+  std::atomic<int64_t> firstSparseRun{ 0 };
+  auto origin = Scheduler::Clock::now();
+  scheduler.AddRepeatingTask([&]() {
+    if (sparseRuns++ == 0) {
+      firstSparseRun = duration_cast<microseconds>(Scheduler::Clock::now() - origin).count();
+    }
+  }, 260ms, system_clock::now() + 600ms);
+
+  std::this_thread::sleep_for(100ms);
+  scheduler.AddTask([]() {});
+  std::this_thread::sleep_for(20ms);
+  std::atomic<int> laterRuns{ 0 };
+  scheduler.AddRepeatingTask([&]() { laterRuns++; }, 200ms, system_clock::now() + 300ms);
+  scheduler.AddTask(std::make_pair(Task([]() {}), Scheduler::Clock::now() + 10ms));
+
+  std::this_thread::sleep_for(700ms);
+  NDTECH_CHECK(sparseRuns == 2);
+  NDTECH_CHECK(laterRuns == 1);
+  NDTECH_CHECK(firstSparseRun >= 260000);
+  NDTECH_CHECK(firstSparseRun < 280000);
+
+  // Then enough tasks to keep level 0 busy
+  const int denseTaskCount = 64;
+  std::vector<std::atomic<int>> denseRuns(denseTaskCount);
+  for (int index = 0; index < denseTaskCount; index++) {
+    scheduler.AddRepeatingTask([&denseRuns, index]() { denseRuns[index]++; }, milliseconds(5 + index), system_clock::now() + 500ms);
+  }
+
+  std::this_thread::sleep_for(600ms);
+  scheduler.Join();
+
+  for (int index = 0; index < denseTaskCount; index++) {
+    // Late runs are coalesced, so a busy machine may see fewer, never more
+    int dueRuns = 500 / (5 + index);
+    NDTECH_CHECK(denseRuns[index] <= dueRuns);
+    NDTECH_CHECK(denseRuns[index] >= dueRuns / 2);
+  }
+}
+
+int main() {
+  HeapPopsInTimeThenSequenceOrder();
+  WheelReleasesWhatHeapReleases();
+  WheelNextTimeLooksAtEveryLevel();
+  SchedulerRunsDelayedTasksByDeadline();
+  SchedulerRunsRepeatingTasksThroughTheWheel();
+  return 0;
+}
\ No newline at end of file
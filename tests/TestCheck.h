@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+// Checked in every build type, unlike assert.  Exits without running destructors, which
+// could wait forever on a store fiber or pool thread the failed test left running.
+#define NDTECH_CHECK(condition) \
+  do { \
+    if (!(condition)) { \
+      std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+      std::fflush(stderr); \
+      std::_Exit(1); \
+    } \
+  } while (false)
@@ -0,0 +1,55 @@
+#include "WorkerPool.h"
+#include "TestCheck.h"
+
+#include <ctime>
+
+using namespace ndtech;
+using namespace std::chrono;
+
+// Idle workers sleep until work is pushed rather than polling for it
+void IdleWorkersSleep() {
+  WorkerPool pool(4);
+  std::this_thread::sleep_for(milliseconds(50));
+
+  std::clock_t start = std::clock();
+  std::this_thread::sleep_for(milliseconds(500));
+  double cpuMilliseconds = 1000.0 * (std::clock() - start) / CLOCKS_PER_SEC;
+  // Four workers polling every millisecond come to thousands of wakeups over the sleep
+  NDTECH_CHECK(cpuMilliseconds < 5.0);
+
+  pool.Join();
+}
+
+// A task pushed onto a busy worker's own deque wakes an idle worker to steal it.  The
+// parent spins until its child has run, so only another worker can run the child.
+void PushesWakeIdleWorkers() {
+  WorkerPool pool(2);
+
+  for (int round = 0; round < 1000; round++) {
+    std::atomic<bool> childRan{ false };
+    std::atomic<bool> parentDone{ false };
+    pool.Submit([&]() {
+      pool.Submit([&childRan]() { childRan = true; });
+      auto deadline = steady_clock::now() + seconds(30);
+      while (!childRan) {
+        NDTECH_CHECK(steady_clock::now() < deadline);
+        std::this_thread::yield();
+      }
+      parentDone = true;
+    });
+
+    auto deadline = steady_clock::now() + seconds(30);
+    while (!parentDone) {
+      NDTECH_CHECK(steady_clock::now() < deadline);
+      std::this_thread::yield();
+    }
+  }
+
+  pool.Join();
+}
+
+int main() {
+  IdleWorkersSleep();
+  PushesWakeIdleWorkers();
+  return 0;
+}
\ No newline at end of file